@@ -90,6 +90,7 @@ private:
   float replacement;
   unsigned int min_replace_size; // don't replace graphs with at least this number of vertices
   bool random_replacement;
+  bool no_replacement;           // grow buffer rather than evict
 public:
   // max_size in bytes
   simple_cache(uint64_t max_size, size_t nbs = 10000) {
@@ -103,6 +104,7 @@ public:
     start_p = new unsigned char[max_size];
     next_p = start_p;
     random_replacement=false;
+    no_replacement=false;
     replacement=0.3;
     min_replace_size = UINT_MAX; // by default, all graphs are replaceable
   }
@@ -189,6 +191,12 @@ public:
     random_replacement=true;
   }
 
+  // When set, entries are never evicted.  Instead, the buffer is
+  // doubled in size whenever it fills up.
+  void set_no_replacement() {
+    no_replacement=true;
+  }
+
   void set_replace_size(unsigned int minsize) {
     min_replace_size = minsize;
   }
@@ -206,27 +214,22 @@ public:
     } 
     bufsize = max_size;
     start_p = new unsigned char[max_size];
-
-    // update simple pointers
-    uint64_t diff = start_p - ostart_p;   
-    next_p = next_p + diff;
+    next_p = start_p + old_size;
 
     // first, copy old data into new location
     memcpy(start_p,ostart_p,old_size);
-    // now, update pointers and links    
+    // now, update links so they point into the new buffer
     for(int i=0;i!=nbuckets;++i) {
-      if(buckets[i].next != NULL) {
-	buckets[i].next += diff;
-	struct cache_node *ptr = buckets[i].next;
-	while(ptr != NULL) {
-	  unsigned char *p = (unsigned char *) ptr->next;
-	  p += diff;
-	  ptr->next = (struct cache_node *) p;
-	  ptr = ptr->next;
-	}
+      struct cache_node *prev = &(buckets[i]);
+      struct cache_node *ptr = buckets[i].next;
+      while(ptr != NULL) {
+	ptr = (struct cache_node *) (start_p + (((unsigned char *) ptr) - ostart_p));
+	prev->next = ptr;
+	ptr->prev = prev;
+	prev = ptr;
+	ptr = ptr->next;
       }
     }
-    // done ?
     delete [] ostart_p;
   }
 
@@ -330,6 +333,10 @@ private:
   }  
 
   inline unsigned char *alloc_node(uint64_t size) {
+    if(no_replacement) {
+      while(((next_p-start_p)+size) >= bufsize) { resize(bufsize*2); }
+    }
+
     // cannot ask for more than the buffer can contain
     if(size >= bufsize) { throw std::bad_alloc();  }
 
@@ -7,16 +7,24 @@
 // Email: david.pearce@mcs.vuw.ac.nz
 
 #include <stdint.h>
+#include <algorithm>
 #include "algorithms.hpp"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 setword *nauty_graph_buf = NULL;
 setword *nauty_workspace = NULL;
 size_t nauty_graph_buf_size=0;
 size_t _nauty_workspace_size = 0;
-
-extern "C" {
-uint32_t hashlittle( const void *key, size_t length, uint32_t initval);
-}
+bool nauty_profile = false;
+unsigned long nauty_calls = 0;
+double nauty_time = 0;
+std::ostream *graph_key_dump = NULL;
+bool use_key_memo = true;
+static nauty_labeller default_labeller;
+canonical_labeller *graph_labeller = &default_labeller;
+unsigned long key_memo_hits = 0;
 
 void resize_nauty_workspace(int newsize) {
   nauty_workspace = new setword[newsize];
@@ -30,23 +38,23 @@ size_t nauty_workspace_size() {
 bool compare_graph_keys(unsigned char const *_k1, unsigned char const *_k2) {
   setword *k1 = (setword*) _k1;
   setword *k2 = (setword*) _k2;
-  
-  setword N1 = k1[0];
-  setword N2 = k2[0];
-  setword REAL_N1 = k1[1];
-  setword REAL_N2 = k2[1];
-
-  if(N1 != N2 || REAL_N1 != REAL_N2) { return false; }
-  else {
-    k1=k1+NAUTY_HEADER_SIZE;
-    k2=k2+NAUTY_HEADER_SIZE;
-    setword M = ((N1 % WORDSIZE) > 0) ? (N1 / WORDSIZE)+1 : N1 / WORDSIZE;
-    for(int i=0;i!=(N1*M);++i,++k1,++k2) {
-      if(*k1 != *k2) { 	return false; }
-    }
+
+  // the header includes the hash, so most mismatches fail here
+  for(int i=0;i!=NAUTY_HEADER_SIZE;++i) {
+    if(k1[i] != k2[i]) { return false; }
   }
-  // success!
-  return true;
+
+  size_t nbytes = sizeof_graph_key(_k1);
+  size_t i = NAUTY_HEADER_SIZE * sizeof(setword);
+#ifdef __SSE2__
+  // compare 16 bytes at a time
+  for(;(i+16) <= nbytes;i+=16) {
+    __m128i a = _mm_loadu_si128((__m128i const *) (_k1+i));
+    __m128i b = _mm_loadu_si128((__m128i const *) (_k2+i));
+    if(_mm_movemask_epi8(_mm_cmpeq_epi8(a,b)) != 0xFFFF) { return false; }
+  }
+#endif
+  return memcmp(_k1+i,_k2+i,nbytes-i) == 0;
 }
 
 // returns the sizeof the graph key in bytes
@@ -57,12 +65,80 @@ size_t sizeof_graph_key(unsigned char const *key) {
   return ((N*M)+NAUTY_HEADER_SIZE) * sizeof(setword);
 }
 
-// generate a hash code from a graph key
-unsigned int hash_graph_key(unsigned char const *key) {
-  setword *p = (setword*) key;  
-  setword N = p[0];
-  setword M = ((N % WORDSIZE) > 0) ? (N / WORDSIZE)+1 : N / WORDSIZE;
-  return hashlittle(key,sizeof(setword)*((N*M)+NAUTY_HEADER_SIZE),0);
+// returns the hash code stored in a graph key's header
+uint64_t hash_graph_key(unsigned char const *key) {
+  uint64_t r;
+  memcpy(&r,key+(2*sizeof(setword)),sizeof(uint64_t));
+  return r;
+}
+
+// -------------------------------
+// Key Hashing
+// -------------------------------
+
+// This is a multiply-mix hash in the style of wyhash.  The key is
+// consumed in 16 byte blocks by two independent lanes, so that the
+// multiplies can proceed in parallel.
+
+#define KEY_HASH_P0 UINT64_C(0xa0761d6478bd642f)
+#define KEY_HASH_P1 UINT64_C(0xe7037ed1a0b428db)
+#define KEY_HASH_P2 UINT64_C(0x8ebc6af09c88c6e3)
+#define KEY_HASH_P3 UINT64_C(0x589965cc75374cc3)
+
+static inline uint64_t key_hash_mix(uint64_t a, uint64_t b) {
+#ifdef __SIZEOF_INT128__
+  unsigned __int128 r = (unsigned __int128) a * b;
+  return ((uint64_t) r) ^ ((uint64_t) (r >> 64));
+#else
+  uint64_t ha = a >> 32, hb = b >> 32, la = (uint32_t) a, lb = (uint32_t) b;
+  uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+  uint64_t t = rl + (rm0 << 32);
+  uint64_t c = t < rl;
+  uint64_t lo = t + (rm1 << 32);
+  c += lo < t;
+  uint64_t hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+  return lo ^ hi;
+#endif
+}
+
+static inline uint64_t key_hash_read(unsigned char const *p) {
+  uint64_t r;
+  memcpy(&r,p,sizeof(uint64_t));
+  return r;
+}
+
+uint64_t key_hash_bytes(unsigned char const *p, size_t len, uint64_t seed) {
+  uint64_t s1 = seed ^ KEY_HASH_P0;
+  uint64_t s2 = seed ^ KEY_HASH_P3;
+  size_t i = 0;
+  for(;(i+32) <= len;i+=32) {
+    s1 = key_hash_mix(key_hash_read(p+i) ^ KEY_HASH_P1, key_hash_read(p+i+8) ^ s1);
+    s2 = key_hash_mix(key_hash_read(p+i+16) ^ KEY_HASH_P2, key_hash_read(p+i+24) ^ s2);
+  }
+  s1 ^= s2;
+  for(;(i+16) <= len;i+=16) {
+    s1 = key_hash_mix(key_hash_read(p+i) ^ KEY_HASH_P1, key_hash_read(p+i+8) ^ s1);
+  }
+  // the remainder is less than 16 bytes
+  uint64_t a = 0, b = 0;
+  if((len - i) >= 8) {
+    a = key_hash_read(p+i);
+    i += 8;
+  }
+  unsigned char tail[8] = {0,0,0,0,0,0,0,0};
+  memcpy(tail,p+i,len-i);
+  b = key_hash_read(tail);
+  return key_hash_mix(KEY_HASH_P1 ^ len, key_hash_mix(a ^ KEY_HASH_P1, b ^ s1));
+}
+
+// generate a hash code from a graph key.  This covers everything
+// except the hash field itself.
+uint64_t compute_graph_key_hash(unsigned char const *key) {
+  size_t nbytes = sizeof_graph_key(key);
+  size_t hbytes = NAUTY_HEADER_SIZE * sizeof(setword);
+  setword *p = (setword*) key;
+  uint64_t seed = key_hash_mix(((uint64_t) p[0]) ^ KEY_HASH_P0, ((uint64_t) p[1]) ^ KEY_HASH_P2);
+  return key_hash_bytes(key+hbytes,nbytes-hbytes,seed);
 }
 
 void print_graph_key(std::ostream &ostr, unsigned char const *key) {
@@ -116,3 +192,188 @@ bool nauty_add_edge(int from, int to, int M) {
   return true;
 }
 
+
+// -------------------------------
+// Key Memo
+// -------------------------------
+
+// The key memo maps a labelled nauty graph (i.e. the contents of
+// nauty_graph_buf) to its canonical key.  This allows identical
+// labelled graphs, such as repeated biconnected components, to avoid
+// calling nauty.  The memo is direct-mapped, with entries indexed by a
+// hash of the labelled graph, and hits are verified exactly.
+
+#define KEY_MEMO_SIZE 256
+
+struct key_memo_entry {
+  uint64_t hash;
+  setword N;
+  setword NN;
+  setword *graph;      // labelled graph (NN*M words)
+  size_t graph_size;   // capacity of graph in words
+  unsigned char *key;  // canonical key
+  size_t key_size;     // capacity of key in bytes
+};
+
+static struct key_memo_entry key_memo[KEY_MEMO_SIZE];
+
+unsigned char *lookup_key_memo(setword N, setword NN, setword M, uint64_t &hash) {
+  size_t nwords = NN*M;
+  hash = key_hash_bytes((unsigned char const *) nauty_graph_buf,nwords*sizeof(setword),N);
+  struct key_memo_entry &e = key_memo[hash % KEY_MEMO_SIZE];
+  if(e.graph != NULL && e.hash == hash && e.N == N && e.NN == NN &&
+     memcmp(e.graph,nauty_graph_buf,nwords*sizeof(setword)) == 0) {
+    size_t nbytes = sizeof_graph_key(e.key);
+    unsigned char *r = (unsigned char *) new setword[nbytes / sizeof(setword)];
+    memcpy(r,e.key,nbytes);
+    key_memo_hits++;
+    return r;
+  }
+  return NULL;
+}
+
+void store_key_memo(uint64_t hash, setword N, setword NN, setword M, unsigned char const *key) {
+  struct key_memo_entry &e = key_memo[hash % KEY_MEMO_SIZE];
+  size_t nwords = NN*M;
+  size_t nbytes = sizeof_graph_key(key);
+  if(e.graph_size < nwords) {
+    delete [] e.graph;
+    e.graph = new setword[nwords];
+    e.graph_size = nwords;
+  }
+  if(e.key_size < nbytes) {
+    delete [] e.key;
+    e.key = new unsigned char[nbytes];
+    e.key_size = nbytes;
+  }
+  e.hash = hash;
+  e.N = N;
+  e.NN = NN;
+  memcpy(e.graph,nauty_graph_buf,nwords*sizeof(setword));
+  memcpy(e.key,key,nbytes);
+}
+
+// -------------------------------
+// Canonical Labelling
+// -------------------------------
+
+// Rather than starting from the unit partition, the real vertices are
+// seeded into cells of equal degree (in ascending order), whilst the
+// vertices added for multi-edges form a final cell.  Degree is an
+// isomorphism invariant, so the canonical graph is still a valid key,
+// but the labeller no longer has to discover this partition itself.
+void seed_partition(setword *g, int N, int NN, int M, int *lab, int *ptn) {
+  int degree[N];
+  int counts[NN+1];
+  memset(counts,0,(NN+1)*sizeof(int));
+  for(int i=0;i!=N;++i) {
+    setword *row = g + (i*M);
+    int d = 0;
+    for(int j=0;j!=M;++j) { d += POPCOUNT(row[j]); }
+    degree[i] = d;
+    counts[d]++;
+  }
+  for(int d=1;d<=NN;++d) { counts[d] += counts[d-1]; }
+  for(int i=N-1;i>=0;--i) { lab[--counts[degree[i]]] = i; }
+  for(int i=0;i!=N-1;++i) {
+    ptn[i] = (degree[lab[i]] == degree[lab[i+1]]) ? 1 : 0;
+  }
+  // vertices added for multi-edges all have degree two
+  for(int i=N;i!=NN;++i) { 
+    lab[i] = i; 
+    ptn[i] = 1;
+  }
+  ptn[NN-1] = 0;
+  ptn[N-1]=0;
+}
+
+void nauty_labeller::canonise(setword *g, int *lab, int *ptn, int m, int n, setword *canong) {
+  statsblk stats;
+  DEFAULTOPTIONS(opts); 
+  opts.getcanon = TRUE;
+  opts.defaultptn = FALSE;
+  opts.writemarkers = FALSE;
+  nvector orbits[n];
+
+  nauty(g,lab,ptn,NULL,orbits,&opts,&stats,nauty_workspace,nauty_workspace_size(),m,n,canong);
+
+  // check for error
+  if(stats.errstatus != 0) {
+    throw std::runtime_error("internal error: nauty returned an error?");
+  }  
+}
+
+// advance perm to the next labelling which respects the partition,
+// returning false when all have been seen.
+static bool next_cell_permutation(int *perm, int *ptn, int n) {
+  int start = 0;
+  for(int i=0;i!=n;++i) {
+    if(ptn[i] == 0) {
+      if(std::next_permutation(perm+start,perm+i+1)) { return true; }
+      // this cell has wrapped around, so move onto the next
+      start = i+1;
+    }
+  }
+  return false;
+}
+
+void tiny_labeller::canonise(setword *g, int *lab, int *ptn, int m, int n, setword *canong) {
+  // first, count the labellings which respect the partition
+  unsigned int count = 1;
+  for(int i=0, size=1;i!=n && count <= max_perms;++i, ++size) {
+    count *= size;
+    if(ptn[i] == 0) { size = 0; }
+  }
+
+  if(m != 1 || count > max_perms) {
+    fallback->canonise(g,lab,ptn,m,n,canong);
+    return;
+  }
+
+  int perm[n];
+  int start = 0;
+  for(int i=0;i!=n;++i) {
+    perm[i] = lab[i];
+    if(ptn[i] == 0) {
+      std::sort(perm+start,perm+i+1);
+      start = i+1;
+    }
+  }
+
+  setword row[n];
+  bool first = true;
+  do {
+    // build rows of the relabelled graph in order, stopping as soon
+    // as it is known to be larger than the best so far.
+    bool smaller = first;
+    int i;
+    for(i=0;i!=n;++i) {
+      setword src = g[perm[i]];
+      setword r = 0;
+      for(int j=0;j!=n;++j) {
+	if(src & bit[perm[j]]) { r |= bit[j]; }
+      }
+      if(!smaller) {
+	if(r > canong[i]) { break; }
+	else if(r < canong[i]) { smaller = true; }
+      }
+      row[i] = r;
+    }
+    if(i == n && smaller) {
+      memcpy(canong,row,n*sizeof(setword));
+    }
+    first = false;
+  } while(next_cell_permutation(perm,ptn,n));
+}
+
+canonical_labeller *create_labeller(std::string const &name) {
+  if(name == "nauty") {
+    return new nauty_labeller();
+  } else if(name == "tiny") {
+    return new tiny_labeller(new nauty_labeller(),TINY_LABELLER_MAX_PERMS);
+  } else if(name == "sparse" || name == "traces") {
+    throw std::runtime_error("labeller \"" + name + "\" is not available (the bundled nauty lacks nausparse.c and traces.c)");
+  } else {
+    throw std::runtime_error("unknown labeller \"" + name + "\"");
+  }
+}
@@ -16,6 +16,8 @@
 #include <cstring>
 #include <vector>
 #include <deque>
+#include <stdint.h>
+#include <sys/time.h>
 
 template<class T>
 std::string graph_str(T const &graph) {
@@ -124,17 +126,85 @@ void breadth_first_search(T const &graph, std::vector<unsigned int> &order) {
 #define MAXN 0
 #include "nauty.h"
 
-#define NAUTY_HEADER_SIZE 2
+// The key header holds the number of vertices (including those added
+// for multi-edges), the number of real vertices and then a 64-bit hash
+// of the key, which is computed once when the key is generated.
+#define NAUTY_HASH_WORDS (64 / WORDSIZE)
+#define NAUTY_HEADER_SIZE (2 + NAUTY_HASH_WORDS)
 
 extern setword *nauty_graph_buf;
 extern size_t nauty_graph_buf_size;
 extern setword *nauty_workspace;
 extern size_t _nauty_workspace_size;
+// the following are used for profiling time spent in nauty
+extern bool nauty_profile;
+extern unsigned long nauty_calls;
+extern double nauty_time;
+// if not NULL, every key generated is written here (for benchmarking)
+extern std::ostream *graph_key_dump;
+// the following are used for the key memo (see algorithms.cpp)
+extern bool use_key_memo;
+extern unsigned long key_memo_hits;
+
+// ----------------------------------
+// CANONICAL LABELLING
+// ----------------------------------
+
+/* A canonical labeller takes a graph g in nauty's dense format, with
+ * n vertices and m setwords per row, together with an initial
+ * partition given as lab/ptn (in the nauty convention).  It writes
+ * into canong the canonical form of g, such that two graphs receive
+ * the same canonical form iff they are isomorphic by a mapping which
+ * respects the partition.  Different labellers may produce different
+ * canonical forms, so only one should be used per run.
+ */
+class canonical_labeller {
+public:
+  virtual ~canonical_labeller() {}
+  virtual char const *name() const = 0;
+  virtual void canonise(setword *g, int *lab, int *ptn, int m, int n, setword *canong) = 0;
+};
+
+// This uses nauty's dense graph mode.
+class nauty_labeller : public canonical_labeller {
+public:
+  char const *name() const { return "nauty"; }
+  void canonise(setword *g, int *lab, int *ptn, int m, int n, setword *canong);
+};
+
+/* This handles tiny graphs by enumerating every labelling which
+ * respects the partition, and choosing that whose adjacency matrix is
+ * smallest.  Graphs for which there are more than max_perms such
+ * labellings are passed to the fallback labeller instead.  The number
+ * of labellings depends only upon the partition, which is itself an
+ * isomorphism invariant, so isomorphic graphs are always handled by
+ * the same labeller.
+ */
+#define TINY_LABELLER_MAX_PERMS 24
+
+class tiny_labeller : public canonical_labeller {
+private:
+  canonical_labeller *fallback;
+  unsigned int max_perms;
+public:
+  tiny_labeller(canonical_labeller *f, unsigned int mp) : fallback(f), max_perms(mp) {}
+  ~tiny_labeller() { delete fallback; }
+  char const *name() const { return "tiny"; }
+  void canonise(setword *g, int *lab, int *ptn, int m, int n, setword *canong);
+};
+
+extern canonical_labeller *graph_labeller;
+canonical_labeller *create_labeller(std::string const &name);
+void seed_partition(setword *g, int N, int NN, int M, int *lab, int *ptn);
 
 void print_graph_key(std::ostream &ostr, unsigned char const *key);
 bool compare_graph_keys(unsigned char const *_k1, unsigned char const *_k2);
 size_t sizeof_graph_key(unsigned char const *key);
-unsigned int hash_graph_key(unsigned char const *key);
+uint64_t hash_graph_key(unsigned char const *key);
+uint64_t compute_graph_key_hash(unsigned char const *key);
+uint64_t key_hash_bytes(unsigned char const *p, size_t len, uint64_t seed);
+unsigned char *lookup_key_memo(setword N, setword NN, setword M, uint64_t &hash);
+void store_key_memo(uint64_t hash, setword N, setword NN, setword M, unsigned char const *key);
 void print_graph_key(std::ostream &ostr, unsigned char const *key);
 bool nauty_add_edge(int from, int to, int M);
 // methods for manipulating workspace
@@ -196,52 +266,59 @@ unsigned char *graph_key(T const &graph) {
   }  
   
   // At this stage, we have constructed a nauty graph representing our
-  // original graph.  We now need to run nauty to generate the
-  // canonical graph which essentially corresponds to our "graph key"
-
-  statsblk stats;
-  DEFAULTOPTIONS(opts); 
-  opts.getcanon = TRUE;
-  opts.defaultptn = FALSE;
-  opts.writemarkers = FALSE;
+  // original graph.  If this exact labelled graph was seen recently,
+  // then reuse its key.  Otherwise, we need to run nauty to generate
+  // the canonical graph which essentially corresponds to our "graph key"
+
+  uint64_t memo_hash;
+  if(use_key_memo) {
+    unsigned char *r = lookup_key_memo(N,NN,M,memo_hash);
+    if(r != NULL) {
+      // the dump lists every key asked for, not just those computed
+      if(graph_key_dump != NULL) {
+	graph_key_dump->write((char const *) r,((NN*M)+NAUTY_HEADER_SIZE)*sizeof(setword));
+      }
+      return r;
+    }
+  }
 
   // could optimise this further by making lab and ptn static
   int lab[NN];
   int ptn[NN];    
-
-  for(int i=0;i!=NN;++i) { 
-    lab[i] = i; 
-    ptn[i] = 1;
-  }
-
-  ptn[NN-1] = 0;
-  ptn[N-1]=0;
-  nvector orbits[NN];
+  seed_partition(nauty_graph_buf,N,NN,M,lab,ptn);
 
   setword *nauty_canong_buf = new setword[((NN*M)+NAUTY_HEADER_SIZE)];
 
-  // call nauty
-  nauty(nauty_graph_buf,
-	lab,
-	ptn,
-	NULL,
-	orbits,
-	&opts,
-	&stats,
-	nauty_workspace,
-	nauty_workspace_size(),
-	M,
-	NN, // true graph size, since includes vertices added for multi edges.
-	nauty_canong_buf+NAUTY_HEADER_SIZE  // add two for header
-	);
-
-  // check for error
-  if(stats.errstatus != 0) {
-    throw std::runtime_error("internal error: nauty returned an error?");
-  }  
+  struct timeval start;
+  if(nauty_profile) { gettimeofday(&start,NULL); }
+
+  graph_labeller->canonise(nauty_graph_buf,
+			   lab,
+			   ptn,
+			   M,
+			   NN, // true graph size, since includes vertices added for multi edges.
+			   nauty_canong_buf+NAUTY_HEADER_SIZE  // leave space for header
+			   );
+
+  nauty_calls++;
+  if(nauty_profile) {
+    struct timeval end;
+    gettimeofday(&end,NULL);
+    nauty_time += (end.tv_sec - start.tv_sec) + ((end.tv_usec - start.tv_usec) / 1000000.0);
+  }
 
   nauty_canong_buf[0] = NN;
   nauty_canong_buf[1] = N;
+  uint64_t hash = compute_graph_key_hash((unsigned char*) nauty_canong_buf);
+  memcpy(nauty_canong_buf+2,&hash,sizeof(uint64_t));
+
+  if(use_key_memo) {
+    store_key_memo(memo_hash,N,NN,M,(unsigned char*) nauty_canong_buf);
+  }
+
+  if(graph_key_dump != NULL) {
+    graph_key_dump->write((char const *) nauty_canong_buf,((NN*M)+NAUTY_HEADER_SIZE)*sizeof(setword));
+  }
 
   return (unsigned char*) nauty_canong_buf;
 }
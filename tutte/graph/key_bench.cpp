@@ -0,0 +1,158 @@
+// (C) Copyright David James Pearce and Gary Haggard, 2007.
+// Permission to copy, use, modify, sell and distribute this software
+// is granted provided this copyright notice appears in all copies.
+// This software is provided "as is" without express or implied
+// warranty, and with no claim as to its suitability for any purpose.
+//
+// Email: david.pearce@mcs.vuw.ac.nz
+
+// Microbenchmark for hashing and comparing graph keys.  The keys are
+// those written by "tutte --dump-keys=<file> ...".  To build (after
+// building the tutte program, so that libnauty.a exists):
+//
+//   gcc -O2 -c hash.c
+//   g++ -O2 -I../../nauty key_bench.cpp algorithms.cpp hash.o ../../nauty/libnauty.a -o key_bench
+//   ./key_bench keys.dat
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include <set>
+#include <cstdlib>
+#include <sys/time.h>
+#include "algorithms.hpp"
+
+using namespace std;
+
+extern "C" {
+uint32_t hashlittle( const void *key, size_t length, uint32_t initval);
+}
+
+double now() {
+  struct timeval tmp;
+  gettimeofday(&tmp,NULL);
+  return tmp.tv_sec + (tmp.tv_usec / 1000000.0);
+}
+
+// the original hash, computed over the whole key
+unsigned int old_hash_graph_key(unsigned char const *key) {
+  return hashlittle(key,sizeof_graph_key(key),0);
+}
+
+// the original comparison, one setword at a time
+bool old_compare_graph_keys(unsigned char const *_k1, unsigned char const *_k2) {
+  setword *k1 = (setword*) _k1;
+  setword *k2 = (setword*) _k2;
+  setword N1 = k1[0];
+  setword N2 = k2[0];
+  if(N1 != N2 || k1[1] != k2[1]) { return false; }
+  k1=k1+NAUTY_HEADER_SIZE;
+  k2=k2+NAUTY_HEADER_SIZE;
+  setword M = ((N1 % WORDSIZE) > 0) ? (N1 / WORDSIZE)+1 : N1 / WORDSIZE;
+  for(int i=0;i!=(N1*M);++i,++k1,++k2) {
+    if(*k1 != *k2) { return false; }
+  }
+  return true;
+}
+
+void report(char const *name, double time, unsigned long count) {
+  cout << setw(24) << left << name << setprecision(3) << ((time * 1000000000) / count) << "ns/key" << endl;
+}
+
+int main(int argc, char *argv[]) {
+  if(argc != 2) {
+    cerr << "usage: " << argv[0] << " <key dump file>" << endl;
+    exit(1);
+  }
+
+  // first, load the keys
+  ifstream in(argv[1],ifstream::binary);
+  vector<unsigned char *> keys;
+  vector<unsigned char *> copies;
+  setword header[NAUTY_HEADER_SIZE];
+  while(in.read((char *) header,sizeof(header))) {
+    setword N = header[0];
+    setword M = ((N % WORDSIZE) > 0) ? (N / WORDSIZE)+1 : N / WORDSIZE;
+    size_t nbytes = ((N*M)+NAUTY_HEADER_SIZE) * sizeof(setword);
+    unsigned char *key = new unsigned char[nbytes];
+    memcpy(key,header,sizeof(header));
+    in.read((char *) key+sizeof(header),nbytes-sizeof(header));
+    keys.push_back(key);
+    unsigned char *copy = new unsigned char[nbytes];
+    memcpy(copy,key,nbytes);
+    copies.push_back(copy);
+  }
+
+  if(keys.size() < 2) {
+    cerr << "insufficient keys in " << argv[1] << endl;
+    exit(1);
+  }
+
+  size_t total = 0;
+  for(unsigned int i=0;i!=keys.size();++i) { total += sizeof_graph_key(keys[i]); }
+  cout << "Keys: " << keys.size() << " (average " << (total / keys.size()) << " bytes)" << endl;
+
+  unsigned int reps = max((size_t)1,(size_t)(20000000 / keys.size()));
+  unsigned long count = ((unsigned long) reps) * keys.size();
+  uint64_t acc = 0;
+
+  // === HASHING ===
+  double start = now();
+  for(unsigned int r=0;r!=reps;++r) {
+    for(unsigned int i=0;i!=keys.size();++i) { acc += old_hash_graph_key(keys[i]); }
+  }
+  report("hashlittle (32-bit):",now()-start,count);
+
+  start = now();
+  for(unsigned int r=0;r!=reps;++r) {
+    for(unsigned int i=0;i!=keys.size();++i) { acc += compute_graph_key_hash(keys[i]); }
+  }
+  report("key hash (64-bit):",now()-start,count);
+
+  // === COMPARISON (EQUAL KEYS) ===
+  start = now();
+  for(unsigned int r=0;r!=reps;++r) {
+    for(unsigned int i=0;i!=keys.size();++i) { acc += old_compare_graph_keys(keys[i],copies[i]); }
+  }
+  report("old compare (equal):",now()-start,count);
+
+  start = now();
+  for(unsigned int r=0;r!=reps;++r) {
+    for(unsigned int i=0;i!=keys.size();++i) { acc += compare_graph_keys(keys[i],copies[i]); }
+  }
+  report("new compare (equal):",now()-start,count);
+
+  // === COMPARISON (ADJACENT KEYS) ===
+  start = now();
+  for(unsigned int r=0;r!=reps;++r) {
+    for(unsigned int i=1;i!=keys.size();++i) { acc += old_compare_graph_keys(keys[i],keys[i-1]); }
+  }
+  report("old compare (adjacent):",now()-start,count);
+
+  start = now();
+  for(unsigned int r=0;r!=reps;++r) {
+    for(unsigned int i=1;i!=keys.size();++i) { acc += compare_graph_keys(keys[i],keys[i-1]); }
+  }
+  report("new compare (adjacent):",now()-start,count);
+
+  // === QUALITY ===
+  // count distinct keys and distinct hash codes (the difference is
+  // the number of collisions).
+  std::set<vector<unsigned char> > distinct;
+  std::set<unsigned int> old_codes;
+  std::set<uint64_t> new_codes;
+  for(unsigned int i=0;i!=keys.size();++i) {
+    distinct.insert(vector<unsigned char>(keys[i],keys[i]+sizeof_graph_key(keys[i])));
+    old_codes.insert(old_hash_graph_key(keys[i]));
+    new_codes.insert(hash_graph_key(keys[i]));
+    if(hash_graph_key(keys[i]) != compute_graph_key_hash(keys[i])) {
+      cerr << "error: stored hash does not match key" << endl;
+      exit(1);
+    }
+  }
+  cout << "Distinct keys: " << distinct.size() << endl;
+  cout << "Distinct 32-bit hashes: " << old_codes.size() << endl;
+  cout << "Distinct 64-bit hashes: " << new_codes.size() << endl;
+  cout << "(checksum " << acc << ")" << endl;
+}
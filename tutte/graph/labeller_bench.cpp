@@ -0,0 +1,128 @@
+// (C) Copyright David James Pearce and Gary Haggard, 2007.
+// Permission to copy, use, modify, sell and distribute this software
+// is granted provided this copyright notice appears in all copies.
+// This software is provided "as is" without express or implied
+// warranty, and with no claim as to its suitability for any purpose.
+//
+// Email: david.pearce@mcs.vuw.ac.nz
+
+// Benchmark for the canonical labelling backends.  The graphs are
+// taken from keys written by "tutte --dump-keys=<file> ...".  Each is
+// randomly relabelled and then canonised by every backend, checking
+// that the result matches that of the original.  To build (after
+// building the tutte program, so that libnauty.a exists):
+//
+//   g++ -O2 -I../../nauty labeller_bench.cpp algorithms.cpp ../../nauty/libnauty.a -o labeller_bench
+//   ./labeller_bench keys.dat
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <sys/time.h>
+#include "algorithms.hpp"
+
+using namespace std;
+
+double now() {
+  struct timeval tmp;
+  gettimeofday(&tmp,NULL);
+  return tmp.tv_sec + (tmp.tv_usec / 1000000.0);
+}
+
+struct bench_graph {
+  setword N;
+  setword NN;
+  setword M;
+  vector<setword> g;
+};
+
+// relabel graph according to permutation p
+vector<setword> relabel(bench_graph const &bg, vector<int> const &p) {
+  vector<setword> r(bg.NN*bg.M,0);
+  for(int i=0;i!=bg.NN;++i) {
+    for(int j=0;j!=bg.NN;++j) {
+      if(ISELEMENT(&bg.g[i*bg.M],j)) { ADDELEMENT(&r[p[i]*bg.M],p[j]); }
+    }
+  }
+  return r;
+}
+
+// canonise graph g using labeller l, writing the result into canong
+void canonise(canonical_labeller *l, bench_graph const &bg, vector<setword> &g, vector<setword> &canong) {
+  int lab[bg.NN];
+  int ptn[bg.NN];
+  seed_partition(&g[0],bg.N,bg.NN,bg.M,lab,ptn);
+  l->canonise(&g[0],lab,ptn,bg.M,bg.NN,&canong[0]);
+}
+
+int main(int argc, char *argv[]) {
+  if(argc != 2) {
+    cerr << "usage: " << argv[0] << " <key dump file>" << endl;
+    exit(1);
+  }
+
+  // first, load the graphs
+  ifstream in(argv[1],ifstream::binary);
+  vector<bench_graph> graphs;
+  setword header[NAUTY_HEADER_SIZE];
+  setword maxM = 0;
+  while(in.read((char *) header,sizeof(header))) {
+    bench_graph bg;
+    bg.NN = header[0];
+    bg.N = header[1];
+    bg.M = ((bg.NN % WORDSIZE) > 0) ? (bg.NN / WORDSIZE)+1 : bg.NN / WORDSIZE;
+    bg.g.resize(bg.NN*bg.M);
+    in.read((char *) &bg.g[0],bg.g.size()*sizeof(setword));
+    graphs.push_back(bg);
+    maxM = max(maxM,bg.M);
+  }
+  cout << "Graphs: " << graphs.size() << endl;
+
+  resize_nauty_workspace(100 * maxM);
+
+  // second, randomly relabel them (keeping the real vertices first)
+  srand(1);
+  vector<vector<setword> > relabelled;
+  for(unsigned int i=0;i!=graphs.size();++i) {
+    bench_graph const &bg(graphs[i]);
+    vector<int> p(bg.NN);
+    for(int j=0;j!=bg.NN;++j) { p[j] = j; }
+    random_shuffle(p.begin(),p.begin()+bg.N);
+    random_shuffle(p.begin()+bg.N,p.end());
+    relabelled.push_back(relabel(bg,p));
+  }
+
+  char const *names[] = { "nauty", "tiny", NULL };
+
+  for(char const **name=names;*name != NULL;++name) {
+    canonical_labeller *l = create_labeller(*name);
+    vector<setword> c1(maxM*WORDSIZE*maxM);
+    vector<setword> c2(maxM*WORDSIZE*maxM);
+
+    // check canonical forms agree
+    for(unsigned int i=0;i!=graphs.size();++i) {
+      bench_graph &bg(graphs[i]);
+      canonise(l,bg,bg.g,c1);
+      canonise(l,bg,relabelled[i],c2);
+      if(!equal(c1.begin(),c1.begin()+(bg.NN*bg.M),c2.begin())) {
+	cerr << "error: " << *name << " gives different canonical forms for graph " << i << endl;
+	exit(1);
+      }
+    }
+
+    // now, time them
+    unsigned int reps = max((size_t)1,(size_t)(200000 / graphs.size()));
+    double start = now();
+    for(unsigned int r=0;r!=reps;++r) {
+      for(unsigned int i=0;i!=graphs.size();++i) {
+	canonise(l,graphs[i],relabelled[i],c1);
+      }
+    }
+    double time = now() - start;
+    cout << setw(8) << left << *name << setprecision(3) << ((time * 1000000000) / (reps * graphs.size())) << "ns/graph" << endl;
+    delete l;
+  }
+}
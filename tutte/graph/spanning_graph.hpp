@@ -96,6 +96,7 @@ public:
       graph.remove(line[i].second);
     }
     check_biconnectivity();
+    return true;
   }
 
   bool remove_edge(int from, int to) {     
@@ -193,6 +194,75 @@ public:
     ncomponents = 99; // not sure how many there are ...
   }
 
+  // Find a separation pair {u,v} of this (biconnected) graph, such
+  // that the component of G - {u,v} containing w, and the rest of G -
+  // {u,v}, both have at least min vertices.  Of those pairs found, the
+  // one which splits the graph most evenly is chosen.  For each vertex
+  // u in turn, this looks for articulation points of G - u, and so it
+  // takes O(V(V+E)) time.
+  bool separation_pair(unsigned int &u, unsigned int &v, unsigned int &w, unsigned int min) {
+    static bc_dat data;
+    unsigned int n = graph.num_vertices();
+    unsigned int best = 0;
+    for(typename G::vertex_iterator i(graph.begin_verts());i!=graph.end_verts();++i) {
+      data.reset(graph.domain_size());
+      data.visited[*i] = true;
+      unsigned int root = *graph.begin_verts();
+      if(root == *i) { root = *(++graph.begin_verts()); }
+      unsigned int b = best;
+      separate(root,root,n,min,best,v,w,data);
+      if(best > b) { u = *i; }
+    }
+    return best > 0;
+  }
+
+  // Split off the component of G - {u,v} containing w, which is
+  // returned along with (copies of) u and v and the edges joining them
+  // to it.  The component is removed from this graph, which leaves
+  // any edges between u and v here.
+  spanning_graph<G> split_off(unsigned int u, unsigned int v, unsigned int w) {
+    spanning_graph<G> g(graph.domain_size());
+    std::vector<bool> visited(graph.domain_size(),false);
+    std::vector<unsigned int> component;
+    visited[u] = true;
+    visited[v] = true;
+    visited[w] = true;
+    component.push_back(w);
+    for(unsigned int k=0;k!=component.size();++k) {
+      unsigned int x = component[k];
+      for(typename G::edge_iterator j(graph.begin_edges(x));j!=graph.end_edges(x);++j) {
+	// in what follows, I use g.graph to avoid rechecking
+	// biconnectivity every time...
+	if(j->first == u || j->first == v || x <= j->first) {
+	  g.graph.add_edge(x,j->first,j->second);
+	}
+	if(!visited[j->first]) {
+	  visited[j->first] = true;
+	  component.push_back(j->first);
+	}
+      }
+    }
+
+    // finally, remove any dumb vertices!
+    for(unsigned int i=0;i!=graph.domain_size();++i) {
+      if(g.num_edges(i) == 0) { g.graph.remove(i); }
+    }
+    for(unsigned int k=0;k!=component.size();++k) {
+      graph.remove(component[k]);
+    }
+
+    g.check_biconnectivity();
+    check_biconnectivity();
+
+    return g;
+  }
+
+  // identify vertices u and v, turning any edges between them into loops
+  void identify(unsigned int u, unsigned int v) {
+    graph.contract_edge(u,v);
+    check_biconnectivity();
+  }
+
   vertex_iterator begin_verts() const { return graph.begin_verts(); }
   vertex_iterator end_verts() const { return graph.end_verts(); }
   
@@ -279,6 +349,39 @@ private:
     }
   }
 
+  // Depth-first search of the graph without those vertices already
+  // marked visited, looking for articulation points.  The subtree
+  // below a child w of v is a component of the graph without v when
+  // lowlink[w] >= dfsnum[v], and its size is the number of vertices
+  // numbered since w.  The smaller side of the best such split so far
+  // is kept in best, with v and w in bv and bw.
+  void separate(unsigned int u, unsigned int v, unsigned int n, unsigned int min,
+		unsigned int &best, unsigned int &bv, unsigned int &bw, bc_dat &data) {
+    data.dfsnum[v] = data.vindex;
+    data.visited[v] = true;
+    data.lowlink[v] = data.vindex++;
+    for(typename G::edge_iterator i(graph.begin_edges(v));
+	i!=graph.end_edges(v);++i) {
+      unsigned int w = i->first;
+      if(!data.visited[w]) {
+	separate(v,w,n,min,best,bv,bw,data);
+	data.lowlink[v] = std::min(data.lowlink[v],data.lowlink[w]);
+	if(data.lowlink[w] >= data.dfsnum[v]) {
+	  // the two sides, less v and the vertex removed
+	  unsigned int s = data.vindex - data.dfsnum[w];
+	  unsigned int t = std::min(s,n - 2 - s);
+	  if(t >= min && t > best) {
+	    best = t;
+	    bv = v;
+	    bw = w;
+	  }
+	}
+      } else if(u != w && data.dfsnum[v] > data.dfsnum[w]) {
+	data.lowlink[v] = std::min(data.lowlink[v],data.dfsnum[w]);
+      }
+    }
+  }
+
   spanning_graph<G> extract_biconnect(edge_t e, bc_dat &data) {
     spanning_graph<G> g(graph.domain_size());
     edge_t c(0,0,0);
@@ -91,67 +91,52 @@ bool bigint::operator>=(bigint const &v) const { return !(*this < v); }
 
 /* ========= OPERATOR + ========== */
 
-void bigint::operator+=(int32_t w) {
-  uint32_t w_magnitude = my_abs(w);
-  if((w<0) != sign) {
-    // neg + pos, pos + neg
-    if(magnitude < w_magnitude) {
-      // swap sign here
-      magnitude = biguint(w_magnitude) - magnitude;
-      sign = !sign;
+// Add (or, when wsign is true, subtract) the magnitude w.  When both
+// magnitudes are held inline, as the vast majority are, the result is
+// found directly in machine words.  Otherwise, the smaller magnitude
+// is subtracted from the larger in place, so neither is copied.
+void bigint::add(biguint const &w, bool wsign) {
+  if(((magnitude.ptr | w.ptr) & BUI_LEFTMOST_BIT) == 0) {
+    // both are below BUI_LEFTMOST_WORD, so the sum cannot overflow
+    bui_word_t a = magnitude.ptr, b = w.ptr;
+    if(wsign == sign) {
+      if((a + b) < BUI_LEFTMOST_WORD) { magnitude.ptr = a + b; }
+      else { magnitude += w; }
+    } else if(a >= b) {
+      magnitude.ptr = a - b;
+      if(a == b) { sign = false; }
     } else {
-      magnitude -= w_magnitude;
-      if(magnitude == UINT32_C(0)) { sign = false; }
+      magnitude.ptr = b - a;
+      sign = wsign;
     }
-  } else {
+  } else if(wsign == sign) {
     // neg + neg, pos + pos.
-    magnitude += w_magnitude;
+    magnitude += w;
+  } else if(magnitude >= w) {
+    // neg + pos, pos + neg
+    magnitude -= w;
+    if(magnitude == UINT32_C(0)) { sign = false; }
+  } else {
+    // swap sign here
+    magnitude.sub_from(w);
+    sign = wsign;
   }
 }
 
+void bigint::operator+=(int32_t w) {
+  add(biguint(my_abs(w)),w < 0);
+}
+
 void bigint::operator+=(uint32_t w) {
-  if(sign) {
-    if(magnitude <= w) {
-      // swap sign here
-      magnitude = biguint(w) - magnitude;
-      sign = false;
-    } else {
-      magnitude -= w;
-    }
-  } else {
-    magnitude += w;
-  }
+  add(biguint(w),false);
 }
 
 void bigint::operator+=(bigint const &w) {
-  if(w.sign != sign) {
-    // neg + pos, pos + neg
-    if(magnitude < w.magnitude) {
-      // swap sign here
-      magnitude = w.magnitude - magnitude;
-      sign = !sign;
-    } else {
-      magnitude -= w.magnitude;
-      if(magnitude == UINT32_C(0)) { sign = false; }
-    }
-  } else {
-    // neg + neg, pos + pos.
-    magnitude += w.magnitude;
-  }
+  add(w.magnitude,w.sign);
 }
 
 void bigint::operator+=(biguint const &w) {
-  if(sign) {
-    if(magnitude <= w) {
-      // swap sign here
-      magnitude = w - magnitude;
-      sign = false;
-    } else {
-      magnitude -= w;
-    }
-  } else {
-    magnitude += w;
-  }
+  add(w,false);
 }
 
 bigint bigint::operator+(int32_t w) const {
@@ -178,64 +163,19 @@ bigint bigint::operator+(biguint const &w) const {
 /* ========= OPERATOR - ========== */
 
 void bigint::operator-=(int32_t w) {
-  uint32_t w_magnitude = my_abs(w);
-  if((w<0) == sign) {
-    // neg - neg, pos - pos
-    if(magnitude < w_magnitude) {
-      // swap sign here
-      magnitude = biguint(w_magnitude) - magnitude;
-      sign = !sign;
-    } else {
-      magnitude -= w_magnitude;
-      if(magnitude == UINT32_C(0)) { sign = false; }      
-    }
-  } else {
-    // neg - pos, pos - neg.
-    magnitude += w_magnitude;
-  }
+  add(biguint(my_abs(w)),w >= 0);
 }
+
 void bigint::operator-=(uint32_t w) {
-  if(!sign) {
-    if(magnitude < w) {
-      // swap sign here
-      magnitude = biguint(w) - magnitude;
-      sign = true;
-    } else {
-      magnitude -= w;
-    }
-  } else {
-    magnitude += w;
-  }
+  add(biguint(w),true);
 }
+
 void bigint::operator-=(bigint const &w) {
-  if(w.sign == sign) {
-    // neg + pos, pos + neg
-    if(magnitude < w.magnitude) {
-      // swap sign here
-      magnitude = w.magnitude - magnitude;
-      sign = !sign;
-    } else {
-      magnitude -= w.magnitude;
-      if(magnitude == UINT32_C(0)) { sign = false; }
-    }
-  } else {
-    // neg + neg, pos + pos.
-    magnitude += w.magnitude;
-  }
+  add(w.magnitude,!w.sign);
 }
 
 void bigint::operator-=(biguint const &w) {
-  if(!sign) {
-    if(magnitude < w) {
-      // swap sign here
-      magnitude = w - magnitude;
-      sign = true;
-    } else {
-      magnitude -= w;
-    }
-  } else {
-    magnitude += w;
-  }
+  add(w,true);
 }
 
 bigint bigint::operator-(int32_t w) const {
@@ -368,14 +308,8 @@ bigint bigint::operator%(uint32_t v) const {
 /* ========= OPERATOR ^ ========== */
 
 void bigint::operator^=(uint32_t v) {
-  if(v == UINT32_C(0)) { (*this) = INT32_C(1); }
-  else {
-    bigint p(*this);
-    
-    for(unsigned int i=1;i<v;++i) {
-      (*this) *= p;
-    }
-  }
+  magnitude ^= v;
+  sign = sign && (v & 1U);
 }
 
 bigint bigint::operator^(uint32_t v) const {
@@ -390,7 +324,7 @@ bigint bigint::operator^(uint32_t v) const {
 
 int32_t bigint::c_int32() const {
   uint32_t w = magnitude.c_uint32();
-  if((!sign && (w > INT32_MAX)) || w >= INT32_MAX) {
+  if(w > (sign ? ((uint32_t) INT32_MAX)+1 : (uint32_t) INT32_MAX)) {
     throw runtime_error("bigint too large for int32");
   } 
   if(sign) { return -w; } 
@@ -399,7 +333,7 @@ int32_t bigint::c_int32() const {
 
 int64_t bigint::c_int64() const {
   uint64_t w = magnitude.c_uint64();
-  if((!sign && (w > INT64_MAX)) || w >= INT64_MAX) {
+  if(w > (sign ? ((uint64_t) INT64_MAX)+1 : (uint64_t) INT64_MAX)) {
     throw runtime_error("bigint too large for int64");
   } 
   if(sign) { return -w; } 
@@ -420,6 +354,18 @@ std::ostream& operator<<(ostream &out, bigint const &val) {
   }
 }
 
+bstreambuf &operator<<(bstreambuf &bout, bigint const &src) {
+  bout << (uint32_t) src.sign << src.magnitude;
+  return bout;
+}
+
+bistream &operator>>(bistream &bin, bigint &src) {
+  uint32_t sign;
+  bin >> sign >> src.magnitude;
+  src.sign = sign != 0;
+  return bin;
+}
+
 /* =============================== */
 /* ======== OTHER METHODS ======= */
 /* =============================== */
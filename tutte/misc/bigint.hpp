@@ -2,6 +2,8 @@
 #define BIGINT_HPP
 
 #include <stdexcept>
+#include <algorithm>
+#include <utility>
 #include "biguint.hpp"
 
 #ifndef INT32_MAX
@@ -33,6 +35,10 @@ private:
   bool sign; // true = negative  
 
   friend std::ostream &operator<<(std::ostream &, bigint const &);
+  friend bstreambuf &operator<<(bstreambuf &, bigint const &);
+  friend bistream &operator>>(bistream &, bigint &);
+
+  void add(biguint const &w, bool wsign);
 public:
   bigint(int32_t v);
   bigint(int64_t v);
@@ -40,6 +46,34 @@ public:
   bigint(uint64_t v);
   bigint(bigint const &v);
   bigint(biguint const &v);
+#ifdef BUI_MOVE_SEMANTICS
+  bigint(bigint &&v) BUI_NOEXCEPT : magnitude(std::move(v.magnitude)), sign(v.sign) { v.sign = false; }
+  bigint(biguint &&v) BUI_NOEXCEPT : magnitude(std::move(v)), sign(false) {}
+#endif
+
+  /* =============================== */
+  /* ======== ASSIGNMENT OPS ======= */
+  /* =============================== */
+
+  bigint const &operator=(bigint const &v) {
+    magnitude = v.magnitude;
+    sign = v.sign;
+    return *this;
+  }
+
+#ifdef BUI_MOVE_SEMANTICS
+  bigint const &operator=(bigint &&v) BUI_NOEXCEPT {
+    magnitude = std::move(v.magnitude);
+    sign = v.sign;
+    v.sign = false;
+    return *this;
+  }
+#endif
+
+  void swap(bigint &v) BUI_NOEXCEPT {
+    magnitude.swap(v.magnitude);
+    std::swap(sign,v.sign);
+  }
 
   /* =============================== */
   /* ======== COMPARISON OPS ======= */
@@ -132,4 +166,7 @@ bigint operator+(biguint const &a, bigint const &b);
 bigint operator-(biguint const &a, bigint const &b);
 bigint operator*(biguint const &a, bigint const &b);
 
+bstreambuf &operator<<(bstreambuf &, bigint const &);
+bistream &operator>>(bistream &, bigint &);
+
 #endif
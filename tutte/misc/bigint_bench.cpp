@@ -0,0 +1,101 @@
+// (C) Copyright David James Pearce and Gary Haggard, 2007.
+// Permission to copy, use, modify, sell and distribute this software
+// is granted provided this copyright notice appears in all copies.
+// This software is provided "as is" without express or implied
+// warranty, and with no claim as to its suitability for any purpose.
+//
+// Email: david.pearce@mcs.vuw.ac.nz
+
+// Throughput benchmark for signed (bigint) arithmetic.  Addition and
+// subtraction are timed separately for operands of the same and of
+// opposite signs, since the latter must subtract magnitudes (and, in
+// half the cases here, flip the sign).  The last column is a Horner
+// step at a negative point, as used when evaluating a polynomial at
+// T(-1,-1) and the like.  To build (in a configured tree):
+//
+//   g++ -O2 bigint_bench.cpp bigint.cpp biguint.cpp bstreambuf.cpp bistream.cpp -o bigint_bench
+//   ./bigint_bench
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cstdlib>
+#include <sys/time.h>
+#include "bigint.hpp"
+
+using namespace std;
+
+double now() {
+  struct timeval tmp;
+  gettimeofday(&tmp,NULL);
+  return tmp.tv_sec + (tmp.tv_usec / 1000000.0);
+}
+
+// a random value of the given number of bits
+bigint random_bigint(unsigned int bits) {
+  bigint r(UINT32_C(1));
+  while(bits > 16) {
+    r *= UINT32_C(1) << 16U;
+    r += (uint32_t) (rand() & 0xffff);
+    bits -= 16;
+  }
+  return r;
+}
+
+#define NVALUES 64
+
+// the operations timed, each applied across a table of values
+typedef enum { SAME, MIXED, HORNER } bop;
+
+char const *bop_names[] = { "a +- b", "a +- -b", "a*-3 + b" };
+
+double run(bop op, vector<bigint> &as, vector<bigint> const &bs) {
+  unsigned int reps = 0;
+  bigint sink(INT32_C(0));
+  double start = now(), end;
+  do {
+    for(unsigned int i=0;i!=NVALUES;++i) {
+      switch(op) {
+      case SAME:
+      case MIXED:
+	// each pair leaves a unchanged, so it counts as two operations
+	as[i] += bs[i];
+	as[i] -= bs[i];
+	break;
+      case HORNER:
+	sink = as[i] * INT32_C(-3);
+	sink += bs[i];
+	break;
+      }
+    }
+    ++reps;
+    end = now();
+  } while(end - start < 0.2);
+  unsigned int ops = (op == HORNER) ? 1 : 2;
+  return ((end - start) * 1e9) / (reps * NVALUES * ops);
+}
+
+int main(int argc, char *argv[]) {
+  srand(1);
+  cout << "bigint (" << BUI_WORD_BITS << "-bit words), ns per operation" << endl;
+  cout << setw(8) << "bits";
+  for(unsigned int op=SAME;op<=HORNER;++op) { cout << setw(10) << bop_names[op]; }
+  cout << endl;
+  unsigned int sizes[] = { 16, 32, 48, 62, 128, 512, 2048 };
+  for(unsigned int k=0;k!=7;++k) {
+    unsigned int bits = sizes[k];
+    cout << setw(8) << bits;
+    for(unsigned int op=SAME;op<=HORNER;++op) {
+      // a and b are the same size, so that for opposite signs the
+      // larger magnitude is equally likely to be either.
+      vector<bigint> as, bs;
+      for(unsigned int i=0;i!=NVALUES;++i) {
+	as.push_back(random_bigint(bits));
+	bs.push_back(random_bigint(bits));
+	if(op == MIXED) { bs[i] *= INT32_C(-1); }
+      }
+      cout << setw(10) << setprecision(3) << run((bop) op,as,bs);
+    }
+    cout << endl;
+  }
+}
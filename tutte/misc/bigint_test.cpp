@@ -170,7 +170,7 @@ void primitive_test(unsigned int count, aop op) {
     if((op == SUB || op == DIV) && w1 < w2) { swap(w1,w2); }
     bigint r1(w1);
     bigint r2(w1);
-    long long r3(w1);
+    int64_t r3(w1);
 
     if(op == ADD) {
       r1 += bigint(w2); // bigint bigint
@@ -200,6 +200,47 @@ void primitive_test(unsigned int count, aop op) {
   }
 }
 
+// a random value of either sign, close to a power of two; this is
+// where the inline and array forms of the magnitude meet
+bigint random_boundary() {
+  uint32_t powers[] = { 30, 31, 32, 33, 62, 63, 64, 65, 127, 128, 200 };
+  uint32_t k = powers[rand() % 11];
+  bigint r = bigint(INT32_C(2)) ^ k;
+  r += random_word() % 1000;
+  if(rand() & 1) { r *= INT32_C(-1); }
+  return r;
+}
+
+void mixed_sign_test(unsigned int count) {
+  for(unsigned int i=0;i!=count;++i) {
+    bigint a = random_boundary();
+    bigint b = random_boundary();
+    bigint s = a + b;
+    bigint d = a - b;
+    bigint e = b - a;
+    bigint z = a;
+    z -= a;
+
+    if(s - b != a || s - a != b) {
+      cout << "ERROR: " << a << " + " << b << " gives " << s << endl;
+    } else if(d + b != a || d + e != INT32_C(0) || (d < INT32_C(0)) != (a < b)) {
+      cout << "ERROR: " << a << " - " << b << " gives " << d << ", but " << b << " - " << a << " gives " << e << endl;
+    } else if(z != INT32_C(0) || z < INT32_C(0) || a + (a * INT32_C(-1)) != INT32_C(0)) {
+      cout << "ERROR: " << a << " - " << a << " gives " << z << endl;
+    }
+  }
+
+  for(unsigned int i=0;i!=count;++i) {
+    bigint a(random_word() % 100);
+    uint32_t k = rand() % 40;
+    bigint p(INT32_C(1));
+    for(unsigned int j=0;j!=k;++j) { p *= a; }
+    if((a ^ k) != p) {
+      cout << "ERROR: " << a << " ^ " << k << " gives " << (a ^ k) << ", not " << p << endl;
+    }
+  }
+}
+
 int main(int argc, char *argv[]) {
 
   // ------------------------------
@@ -250,6 +291,8 @@ int main(int argc, char *argv[]) {
     cout << "PRIM SUB DONE" << endl;
     commutative_add_test(count,10000);
     cout << "COMM ADD/SUB DONE" << endl;
+    mixed_sign_test(count);
+    cout << "MIXED SIGN ADD/SUB DONE" << endl;
     primitive_test(count,MUL);
     cout << "PRIM MUL DONE" << endl;
     primitive_test(count,DIV);
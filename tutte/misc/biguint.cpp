@@ -8,37 +8,33 @@
 
 #include <cstring> // for memcpy
 #include <stdexcept>
+#include <vector>
+#include <algorithm>
 
 #include "biguint.hpp"
 
-using namespace std;
-
-/* =============================== */
-/* ========= CONSTRUCTORS ======== */
-/* =============================== */
+// When configured --with-gmp, the inner loops are handed to GMP's mpn
+// layer.  This works on the arrays exactly as they are, since the
+// limbs are simply words (lowest first), so neither the layout nor the
+// stream format changes.
+#ifdef BUI_USE_GMP
+#include <gmp.h>
+#if GMP_LIMB_BITS != BUI_WORD_BITS || GMP_NAIL_BITS != 0
+#error "GMP limbs must match biguint words (which rules out BUI_32BIT_WORDS)"
+#endif
+#define BUI_LIMBS(x) ((mp_limb_t *) (x))
+#define BUI_CLIMBS(x) ((mp_limb_t const *) (x))
+#endif
 
-biguint::biguint(uint32_t v, uint32_t depth) { 
-  uint32_t padding = depth;
-  uint32_t *p = aligned_alloc(depth+padding+2);
-  p[0]=depth;
-  p[1]=padding; 
-
-  memset(p+2,0,(depth+padding)*sizeof(uint32_t));
-  p[2] = v;
-  ptr = BUI_PACK(p);
-}
+using namespace std;
 
-/* =============================== */
-/* ======== ASSIGNMENT OPS ======= */
-/* =============================== */
-  
 /* =============================== */
 /* ======== COMPARISON OPS ======= */
 /* =============================== */
 
 bool biguint::operator==(uint32_t v) const {
   if(ptr & BUI_LEFTMOST_BIT) {    
-    uint32_t *p = BUI_UNPACK(ptr);
+    bui_word_t *p = BUI_UNPACK(ptr);
     if(p[2] != v) { return false; }
     uint32_t depth(p[0]);
     for(uint32_t i=3;i<(depth+2);++i) {
@@ -51,28 +47,18 @@ bool biguint::operator==(uint32_t v) const {
 }
 
 bool biguint::operator==(uint64_t v) const {
-  if(ptr & BUI_LEFTMOST_BIT) {
-    uint32_t *p = BUI_UNPACK(ptr);
-    uint32_t depth(p[0]);
-    for(uint32_t i=2;i<(depth+2);i++) {
-      if(p[i] != (uint32_t) v) { return false; }
-      v >>= 32U;
-    }    
-    if(v != 0) { return false; }
-    return true;
-  } else {
-    return ptr == v;
-  } 
+  uint64_t w;
+  return to_uint64(w) && w == v;
 }
 
 bool biguint::operator==(biguint const &v) const {
   if((ptr & BUI_LEFTMOST_BIT) == 0) {
-    return v == ptr;
+    return v == (bui_word_t) ptr;
   } else if((v.ptr & BUI_LEFTMOST_BIT) == 0) {
-    return (*this) == v.ptr;
+    return (*this) == (bui_word_t) v.ptr;
   } else {
-    uint32_t *p(BUI_UNPACK(ptr));
-    uint32_t *s(BUI_UNPACK(v.ptr));
+    bui_word_t *p(BUI_UNPACK(ptr));
+    bui_word_t *s(BUI_UNPACK(v.ptr));
     uint32_t depth(std::min(p[0],s[0]));
     for(uint32_t i=2;i<(depth+2);i++) {
       if(p[i] != s[i]) { return false; }
@@ -96,7 +82,7 @@ bool biguint::operator!=(biguint const &v) const { return !((*this) == v); }
 
 bool biguint::operator<(uint32_t v) const {
   if(ptr & BUI_LEFTMOST_BIT) {    
-    uint32_t *p = BUI_UNPACK(ptr);
+    bui_word_t *p = BUI_UNPACK(ptr);
     if(p[2] >= v) { return false; }
     uint32_t depth(p[0]);
     for(uint32_t i=3;i<(depth+2);++i) {
@@ -109,21 +95,9 @@ bool biguint::operator<(uint32_t v) const {
 }
 
 bool biguint::operator<(uint64_t v) const {
-  if(ptr & BUI_LEFTMOST_BIT) {    
-    uint32_t *p = BUI_UNPACK(ptr);
-    if(((uint64_t)p[2]) >= v) { return false; }
-    uint32_t depth(p[0]);
-    if(depth == 1) { return true; }
-    uint64_t w = p[3];
-    w = (w << 32U) + p[2];    
-    if(w >= v) { return false; }
-    for(uint32_t i=4;i<(depth+2);++i) {
-      if(p[i] != 0) { return false; }
-    }
-    return true;
-  } else {
-    return ptr < v;
-  } 
+  // anything too large for 64 bits is certainly not less than v
+  uint64_t w;
+  return to_uint64(w) && w < v;
 }
 
 bool biguint::operator<(biguint const &v) const {
@@ -131,14 +105,14 @@ bool biguint::operator<(biguint const &v) const {
     if((v.ptr & BUI_LEFTMOST_BIT) == 0) {      
       return ptr < v.ptr;
     } else {
-      return !(v <= ptr);
+      return !(v <= (bui_word_t) ptr);
     }
   } else if((v.ptr & BUI_LEFTMOST_BIT) == 0) {
-    return (*this < v.ptr);
+    return (*this < (bui_word_t) v.ptr);
   }
   
-  uint32_t *p = BUI_UNPACK(ptr);
-  uint32_t *s = BUI_UNPACK(v.ptr);
+  bui_word_t *p = BUI_UNPACK(ptr);
+  bui_word_t *s = BUI_UNPACK(v.ptr);
 
   uint32_t depth_p(p[0]);
   uint32_t depth_s(s[0]);
@@ -157,8 +131,8 @@ bool biguint::operator<(biguint const &v) const {
 	return false;
       }
     } else {
-      uint32_t sw = s[i];
-      uint32_t pw = p[i];
+      bui_word_t sw = s[i];
+      bui_word_t pw = p[i];
       
       if(sw < pw) {
 	return false;
@@ -174,7 +148,7 @@ bool biguint::operator<(biguint const &v) const {
 
 bool biguint::operator<=(uint32_t v) const {
   if(ptr & BUI_LEFTMOST_BIT) {    
-    uint32_t *p = BUI_UNPACK(ptr);
+    bui_word_t *p = BUI_UNPACK(ptr);
     if(p[2] > v) { return false; }
     uint32_t depth(p[0]);
     for(uint32_t i=3;i<(depth+2);++i) {
@@ -187,21 +161,8 @@ bool biguint::operator<=(uint32_t v) const {
 }
 
 bool biguint::operator<=(uint64_t v) const {
-  if(ptr & BUI_LEFTMOST_BIT) {    
-    uint32_t *p = BUI_UNPACK(ptr);
-    if(((uint64_t)p[2]) > v) { return false; }
-    uint32_t depth(p[0]);
-    if(depth == 1) { return true; }
-    uint64_t w = p[3];
-    w = (w << 32U) + p[2];    
-    if(w > v) { return false; }
-    for(uint32_t i=4;i<(depth+2);++i) {
-      if(p[i] != 0) { return false; }
-    }
-    return true;
-  } else {
-    return ptr <= v;
-  } 
+  uint64_t w;
+  return to_uint64(w) && w <= v;
 }
 
 bool biguint::operator<=(biguint const &v) const {
@@ -209,14 +170,14 @@ bool biguint::operator<=(biguint const &v) const {
     if((v.ptr & BUI_LEFTMOST_BIT) == 0) {
       return ptr <= v.ptr;
     } else {
-      return !(v < ptr);
+      return !(v < (bui_word_t) ptr);
     }
   } else if((v.ptr & BUI_LEFTMOST_BIT) == 0) {
-    return (*this <= v.ptr);
+    return (*this <= (bui_word_t) v.ptr);
   }
   
-  uint32_t *p = BUI_UNPACK(ptr);
-  uint32_t *s = BUI_UNPACK(v.ptr);
+  bui_word_t *p = BUI_UNPACK(ptr);
+  bui_word_t *s = BUI_UNPACK(v.ptr);
 
   uint32_t depth_p(p[0]);
   uint32_t depth_s(s[0]);
@@ -235,8 +196,8 @@ bool biguint::operator<=(biguint const &v) const {
 	return false;
       }
     } else {
-      uint32_t sw = s[i];
-      uint32_t pw = p[i];
+      bui_word_t sw = s[i];
+      bui_word_t pw = p[i];
       
       if(sw < pw) {
 	return false;
@@ -263,35 +224,16 @@ bool biguint::operator>=(biguint const &v) const { return !(*this < v); }
 /* =============================== */
 
 void biguint::operator+=(uint32_t w) {
-  if(ptr & BUI_LEFTMOST_BIT) {    
-    uint32_t *p(BUI_UNPACK(ptr));
-    uint32_t v = p[2];
-    w = v + w;
-    p[2] = w;
-    if(w < v) { ripple_carry(1); }
-  } else {
-    uint32_t v = ptr;
-    ptr = v + w;
-    if(ptr < v) {
-      uint32_t *p = aligned_alloc(4); 
-      p[0] = 2U;
-      p[1] = 0;
-      p[2] = ptr;
-      p[3] = 1U;
-      ptr = BUI_PACK(p);
-    } else if(ptr >= BUI_LEFTMOST_32BIT) {
-      clone(ptr);
-    } 
-  }
+  add_word(w);
 }
 
 void biguint::operator+=(biguint const &src) {
   if((src.ptr & BUI_LEFTMOST_BIT) == 0) { 
-    (*this) += src.ptr; 
+    add_word(src.ptr); 
   } else {
-    uint32_t *s(BUI_UNPACK(src.ptr));
+    bui_word_t *s(BUI_UNPACK(src.ptr));
     uint32_t depth = s[0];
-    uint32_t *p;
+    bui_word_t *p;
     
     if((ptr & BUI_LEFTMOST_BIT) == 0) { 
       // assume it needs to go big
@@ -299,28 +241,24 @@ void biguint::operator+=(biguint const &src) {
       p[0] = depth;      
       p[1] = 0;
       p[2] = ptr;
-      for(int i=3;i<(depth+2);++i) { p[i] = 0U; }
+      for(uint32_t i=3;i<(depth+2);++i) { p[i] = 0U; }
       ptr = BUI_PACK(p);
     } else {
       expand(depth);
       p = BUI_UNPACK(ptr);
     }
 
-    uint32_t carry = 0;
+#ifdef BUI_USE_GMP
+    bui_word_t carry = mpn_add_n(BUI_LIMBS(p+2),BUI_CLIMBS(p+2),BUI_CLIMBS(s+2),depth);
+#else
+    bui_word_t carry = 0;
     
     for(uint32_t i=2;i<(depth+2);++i) {
-      uint32_t v = p[i];
-      uint32_t w = s[i];
-      
-      w = v + w + carry;   
-      p[i] = w;
-      
-      if(carry == 0) {
-	carry = w < v ? 1 : 0;
-      } else {
-	carry = w <= v ? 1 : 0;
-      }
+      bui_dword_t w = ((bui_dword_t) p[i]) + s[i] + carry;
+      p[i] = (bui_word_t) w;
+      carry = (bui_word_t) (w >> BUI_WORD_BITS);
     }
+#endif
     if(carry == 1) { ripple_carry(depth); }
   }   
 }
@@ -338,25 +276,16 @@ biguint biguint::operator+(uint32_t w) const {
 }
 
 void biguint::operator-=(uint32_t w) {
-  if(ptr & BUI_LEFTMOST_BIT) {    
-    uint32_t *p(BUI_UNPACK(ptr));    
-    uint32_t v = p[2];
-    p[2] = v - w;
-    if(v < w) { ripple_borrow(1); }
-  } else {
-    uint32_t v(ptr);
-    ptr = v - w;
-    if(v < w) { throw std::runtime_error("biguint cannot go negative"); }
-  }
+  sub_word(w);
 }
 
 void biguint::operator-=(biguint const &src) {
   if((src.ptr & BUI_LEFTMOST_BIT) == 0) { 
-    (*this) -= src.ptr; 
+    sub_word(src.ptr); 
   } else {
-    uint32_t *s(BUI_UNPACK(src.ptr));
+    bui_word_t *s(BUI_UNPACK(src.ptr));
     uint32_t depth = s[0];
-    uint32_t *p;
+    bui_word_t *p;
 
     if((ptr & BUI_LEFTMOST_BIT) == 0) { 
       // assume it needs to go big
@@ -364,32 +293,78 @@ void biguint::operator-=(biguint const &src) {
       p[0] = depth;      
       p[1] = 0;      
       p[2] = ptr;
-      for(int i=3;i<(depth+2);++i) { p[i] = 0U; }
+      for(uint32_t i=3;i<(depth+2);++i) { p[i] = 0U; }
       ptr = BUI_PACK(p);
     } else {
       expand(depth);
       p = BUI_UNPACK(ptr);
     }
     
-    uint32_t borrow = 0;
+#ifdef BUI_USE_GMP
+    bui_word_t borrow = mpn_sub_n(BUI_LIMBS(p+2),BUI_CLIMBS(p+2),BUI_CLIMBS(s+2),depth);
+#else
+    bui_word_t borrow = 0;
     
     for(uint32_t i=2;i<(depth+2);++i) {
-      uint32_t v = p[i];
-      uint32_t w = s[i];
-      uint32_t r = v - w - borrow;    
-      p[i] = r;
-      
-      if(borrow == 0) {
-	borrow = v < w ? 1 : 0;
-      } else {
-	borrow = v <= w ? 1 : 0;
-      }
+      // a borrow shows up as the top half of w being all ones
+      bui_dword_t w = ((bui_dword_t) p[i]) - s[i] - borrow;
+      p[i] = (bui_word_t) w;
+      borrow = ((bui_word_t) (w >> BUI_WORD_BITS)) & 1U;
     }
+#endif
     
     if(borrow == 1) { ripple_borrow(depth); }
   }
 }
 
+// Set this to src - this, which must not be negative.  This is the
+// same as this = src - this, except that src is not copied, and the
+// memory already held by this is reused where possible.
+void biguint::sub_from(biguint const &src) {
+  if((src.ptr & BUI_LEFTMOST_BIT) == 0) {
+    // since this <= src, all but the first word of this must be zero
+    if(ptr & BUI_LEFTMOST_BIT) {
+      bui_word_t *p(BUI_UNPACK(ptr));
+      if((*this) > src) { throw std::runtime_error("biguint cannot go negative"); }
+      p[2] = src.ptr - p[2];
+    } else {
+      if(ptr > src.ptr) { throw std::runtime_error("biguint cannot go negative"); }
+      ptr = src.ptr - ptr;
+    }
+  } else {
+    bui_word_t *s(BUI_UNPACK(src.ptr));
+    uint32_t depth = s[0];
+    bui_word_t *p;
+
+    if((ptr & BUI_LEFTMOST_BIT) == 0) {
+      p = aligned_alloc(depth+2);
+      p[0] = depth;
+      p[1] = 0;
+      p[2] = ptr;
+      for(uint32_t i=3;i<(depth+2);++i) { p[i] = 0U; }
+      ptr = BUI_PACK(p);
+    } else {
+      expand(depth);
+      p = BUI_UNPACK(ptr);
+    }
+
+#ifdef BUI_USE_GMP
+    bui_word_t borrow = mpn_sub_n(BUI_LIMBS(p+2),BUI_CLIMBS(s+2),BUI_CLIMBS(p+2),depth);
+#else
+    bui_word_t borrow = 0;
+
+    for(uint32_t i=2;i<(depth+2);++i) {
+      bui_dword_t w = ((bui_dword_t) s[i]) - p[i] - borrow;
+      p[i] = (bui_word_t) w;
+      borrow = ((bui_word_t) (w >> BUI_WORD_BITS)) & 1U;
+    }
+#endif
+    // any words of this beyond those of src must be zero
+    for(uint32_t i=depth+2;i<(p[0]+2);++i) { borrow |= (p[i] != 0); }
+    if(borrow == 1) { throw std::runtime_error("biguint cannot go negative"); }
+  }
+}
+
 biguint biguint::operator-(biguint const &w) const {
   biguint r(*this);
   r -= w;
@@ -403,146 +378,284 @@ biguint biguint::operator-(uint32_t w) const {
 }
 
 void biguint::operator*=(uint32_t v) {
-  if(ptr & BUI_LEFTMOST_BIT) {    
-    // complicated case!
-    uint32_t *p(BUI_UNPACK(ptr));
-    uint32_t depth(p[0]);
-    uint32_t overflow = 0;
+  mul_word(v);
+}
 
-    for(uint32_t i=2;i<(depth+2);++i) {
-      uint64_t w = p[i];
-      w = (w * v) + overflow;
-      p[i] = w;
-      overflow = w >> 32U;
-    }
-    
-    if(overflow > 0) {
-      // need additional space
-      expand(depth+1);   
-      p = BUI_UNPACK(ptr); 
-      p[depth+2] = overflow;
-    }
-  } else {    
-    // easier case!
-    uint64_t w = ((uint64_t)ptr) * v;
-    if(w >= BUI_LEFTMOST_32BIT) { 
-      // build new object
-      uint32_t *p = aligned_alloc(4);
-      ptr = BUI_PACK(p);
-      p[0] = 2U;
-      p[1] = 0;
-      p[2] = w;
-      p[3] = w >> 32U;
-    } else {
-      ptr = w;
+/* =============================== */
+/* ==== MULTIPLICATION KERNELS === */
+/* =============================== */
+
+// the number of words in a[0..n) actually used, ignoring leading zeros
+static uint32_t used_length(bui_word_t const *a, uint32_t n) {
+  while(n > 0 && a[n-1] == 0) { --n; }
+  return n;
+}
+
+#ifdef BUI_USE_GMP
+
+// r[0..na+nb) = a * b; GMP picks its own algorithm for each size
+static void mul_arrays(bui_word_t *r, bui_word_t const *a, uint32_t na, bui_word_t const *b, uint32_t nb) {
+  if(na < nb) { std::swap(a,b); std::swap(na,nb); }
+  mpn_mul(BUI_LIMBS(r),BUI_CLIMBS(a),na,BUI_CLIMBS(b),nb);
+}
+
+#else
+
+// The kernels below work on arrays of words (lowest first).  Below
+// BUI_KARATSUBA_THRESHOLD words, schoolbook multiplication is used;
+// above it, Karatsuba's method; and above BUI_TOOM3_THRESHOLD words,
+// Toom-3.  The thresholds were chosen with misc/biguint_bench.cpp.
+#ifndef BUI_KARATSUBA_THRESHOLD
+#define BUI_KARATSUBA_THRESHOLD 48
+#endif
+#ifndef BUI_TOOM3_THRESHOLD
+#define BUI_TOOM3_THRESHOLD 200
+#endif
+
+// r[0..na+nb) = a * b, where r is initially zero
+static void mul_schoolbook(bui_word_t *r, bui_word_t const *a, uint32_t na, bui_word_t const *b, uint32_t nb) {
+  for(uint32_t j=0;j<nb;++j) {
+    bui_word_t v = b[j];
+    if(v == 0) { continue; }
+    bui_word_t carry = 0;
+    bui_word_t *rs = r + j;
+    for(uint32_t i=0;i<na;++i) {
+      bui_dword_t w = (((bui_dword_t) a[i]) * v) + rs[i] + carry;
+      rs[i] = (bui_word_t) w;
+      carry = (bui_word_t) (w >> BUI_WORD_BITS);
     }
+    rs[na] = carry;
   }
 }
 
-void biguint::operator*=(biguint const &src) {
-  // this could probably be optimised ...
-  if((src.ptr & BUI_LEFTMOST_BIT) == 0) { 
-    (*this) *= src.ptr; 
-  } else if((ptr & BUI_LEFTMOST_BIT) == 0) {
-    // could be optimised a little?
-    biguint ans(src);
-    ans *= ptr;
-    swap(ans);
-  } else {
-    uint32_t *s(BUI_UNPACK(src.ptr));
-    uint32_t depth = s[0];
-    biguint ans(0U,depth);
-
-    for(uint32_t j=0;j<depth;++j) {
-      biguint tmp(*this);
-      tmp *= s[j+2];
+// r[0..n) += c * a[0..na), returning the carry out of r[n-1]
+static bui_word_t add_mul_into(bui_word_t *r, uint32_t n, bui_word_t const *a, uint32_t na, bui_word_t c) {
+  bui_word_t carry = 0;
+  uint32_t i = 0;
+  for(;i<na;++i) {
+    bui_dword_t w = (((bui_dword_t) a[i]) * c) + r[i] + carry;
+    r[i] = (bui_word_t) w;
+    carry = (bui_word_t) (w >> BUI_WORD_BITS);
+  }
+  for(;carry != 0 && i<n;++i) {
+    r[i] += carry;
+    carry = (r[i] < carry) ? 1 : 0;
+  }
+  return carry;
+}
 
-      uint32_t *tp(BUI_UNPACK(tmp.ptr));      
-      uint32_t t_depth(tp[0]);
-      uint32_t carry = 0;
+// r[0..n) -= c * a[0..na), returning the borrow out of r[n-1]
+static bui_word_t sub_mul_from(bui_word_t *r, uint32_t n, bui_word_t const *a, uint32_t na, bui_word_t c) {
+  bui_word_t borrow = 0;
+  uint32_t i = 0;
+  for(;i<na;++i) {
+    bui_dword_t w = (((bui_dword_t) a[i]) * c) + borrow;
+    bui_word_t lo = (bui_word_t) w;
+    borrow = (bui_word_t) (w >> BUI_WORD_BITS);
+    if(r[i] < lo) { ++borrow; }
+    r[i] -= lo;
+  }
+  for(;borrow != 0 && i<n;++i) {
+    bui_word_t v = r[i];
+    r[i] = v - borrow;
+    borrow = (v < borrow) ? 1 : 0;
+  }
+  return borrow;
+}
 
-      ans.expand(j + t_depth); 
+static void mul_arrays(bui_word_t *r, bui_word_t const *a, uint32_t na, bui_word_t const *b, uint32_t nb);
+
+// r[0..2n) = a * b, where both have n words and r is initially zero.
+// Splitting a = a0 + a1*B^m (and b likewise), then a*b = a0*b0 +
+// ((a0+a1)*(b0+b1) - a0*b0 - a1*b1)*B^m + a1*b1*B^2m, which needs
+// just three half-size products.  No intermediate value is negative.
+static void mul_karatsuba(bui_word_t *r, bui_word_t const *a, bui_word_t const *b, uint32_t n) {
+  uint32_t m = n / 2;
+  uint32_t h = n - m;
+  mul_arrays(r,a,m,b,m);
+  mul_arrays(r+(2*m),a+m,h,b+m,h);
+  std::vector<bui_word_t> sa(h+1,0), sb(h+1,0);
+  for(uint32_t i=0;i<h;++i) { sa[i] = a[m+i]; sb[i] = b[m+i]; }
+  sa[h] = add_mul_into(&sa[0],h,a,m,1);
+  sb[h] = add_mul_into(&sb[0],h,b,m,1);
+  uint32_t nsa = used_length(&sa[0],h+1);
+  uint32_t nsb = used_length(&sb[0],h+1);
+  if(nsa == 0 || nsb == 0) { return; } // then a and b were zero
+  std::vector<bui_word_t> z(nsa+nsb,0);
+  mul_arrays(&z[0],&sa[0],nsa,&sb[0],nsb);
+  sub_mul_from(&z[0],z.size(),r,used_length(r,2*m),1);
+  sub_mul_from(&z[0],z.size(),r+(2*m),used_length(r+(2*m),2*h),1);
+  add_mul_into(r+m,(2*n)-m,&z[0],used_length(&z[0],z.size()),1);
+}
 
-      uint32_t *ap(BUI_UNPACK(ans.ptr));      
+// r[0..n) = c0*a0 + c1*a1 + c2*a2, for small constants c0, c1 and c2
+static void lincomb(bui_word_t *r, uint32_t n, bui_word_t c0, bui_word_t const *a0, uint32_t n0,
+		    bui_word_t c1, bui_word_t const *a1, uint32_t n1, bui_word_t c2, bui_word_t const *a2, uint32_t n2) {
+  std::fill(r,r+n,0);
+  add_mul_into(r,n,a0,n0,c0);
+  add_mul_into(r,n,a1,n1,c1);
+  add_mul_into(r,n,a2,n2,c2);
+}
 
-      // standard add, although slightly modified
-      // to give the base shift for free.
-      for(uint32_t i=0;i!=t_depth;++i) {
-	uint32_t v = ap[j+i+2];
-	uint32_t w = tp[i+2];
-	
-	w = v + w + carry;   
-	ap[j+i+2] = w;
+// r[0..n) /= v, which must divide it exactly
+static void div_exact(bui_word_t *r, uint32_t n, bui_word_t v) {
+  bui_word_t remainder = 0;
+  for(uint32_t i=n;i>0;--i) {
+    bui_dword_t w = (((bui_dword_t) remainder) << BUI_WORD_BITS) + r[i-1];
+    r[i-1] = (bui_word_t) (w / v);
+    remainder = (bui_word_t) (w % v);
+  }
+}
 
-	if(carry == 0) { carry = w < v ? 1 : 0; } 
-	else { carry = w <= v ? 1 : 0; }
-      }
+// r[0..2n) = a * b, where both have n words and r is initially zero.
+// Splitting a = a0 + a1*B^k + a2*B^2k (and b likewise), the product
+// c0 + c1*B^k + ... + c4*B^4k is recovered from five products of
+// about a third of the size: those at 0 and infinity give c0 and c4,
+// and those at 1, 2 and 1/2 give c1, c2 and c3.  Using 1/2 (scaled
+// by 16) rather than the usual -1 means every intermediate value is
+// nonnegative, so unsigned arithmetic suffices throughout.
+static void mul_toom3(bui_word_t *r, bui_word_t const *a, bui_word_t const *b, uint32_t n) {
+  uint32_t k = (n + 2) / 3;
+  uint32_t l = n - (2*k); // the length of a2 and b2
+  bui_word_t const *a0 = a, *a1 = a + k, *a2 = a + (2*k);
+  bui_word_t const *b0 = b, *b1 = b + k, *b2 = b + (2*k);
+  // c0 and c4 go straight into place
+  mul_arrays(r,a0,k,b0,k);
+  mul_arrays(r+(4*k),a2,l,b2,l);
+  bui_word_t const *c0 = r, *c4 = r + (4*k);
+  // the values at 1, 2 and 1/2
+  std::vector<bui_word_t> pa(k+1), pb(k+1);
+  uint32_t L = (2*k)+2;
+  std::vector<bui_word_t> u(L,0), v(L,0), w(L,0);
+  lincomb(&pa[0],k+1,1,a0,k,1,a1,k,1,a2,l);
+  lincomb(&pb[0],k+1,1,b0,k,1,b1,k,1,b2,l);
+  mul_arrays(&u[0],&pa[0],k+1,&pb[0],k+1);
+  lincomb(&pa[0],k+1,1,a0,k,2,a1,k,4,a2,l);
+  lincomb(&pb[0],k+1,1,b0,k,2,b1,k,4,b2,l);
+  mul_arrays(&v[0],&pa[0],k+1,&pb[0],k+1);
+  lincomb(&pa[0],k+1,4,a0,k,2,a1,k,1,a2,l);
+  lincomb(&pb[0],k+1,4,b0,k,2,b1,k,1,b2,l);
+  mul_arrays(&w[0],&pa[0],k+1,&pb[0],k+1);
+  // u = c1 + c2 + c3
+  sub_mul_from(&u[0],L,c0,2*k,1);
+  sub_mul_from(&u[0],L,c4,2*l,1);
+  // v = c1 + 2c2 + 4c3
+  sub_mul_from(&v[0],L,c0,2*k,1);
+  sub_mul_from(&v[0],L,c4,2*l,16);
+  div_exact(&v[0],L,2);
+  // w = 4c1 + 2c2 + c3
+  sub_mul_from(&w[0],L,c0,2*k,16);
+  sub_mul_from(&w[0],L,c4,2*l,1);
+  div_exact(&w[0],L,2);
+  // v = c2 + 3c3, and w = 3c1 + c2
+  sub_mul_from(&v[0],L,&u[0],L,1);
+  sub_mul_from(&w[0],L,&u[0],L,1);
+  // u = 3(c1 + c2 + c3) - (c2 + 3c3) - (3c1 + c2) = c2
+  std::vector<bui_word_t> t(L,0);
+  add_mul_into(&t[0],L,&u[0],L,3);
+  sub_mul_from(&t[0],L,&v[0],L,1);
+  sub_mul_from(&t[0],L,&w[0],L,1);
+  u.swap(t);
+  // v = c3, and w = c1
+  sub_mul_from(&v[0],L,&u[0],L,1);
+  div_exact(&v[0],L,3);
+  sub_mul_from(&w[0],L,&u[0],L,1);
+  div_exact(&w[0],L,3);
+  // finally, add c1, c2 and c3 into place
+  add_mul_into(r+k,(2*n)-k,&w[0],used_length(&w[0],L),1);
+  add_mul_into(r+(2*k),(2*n)-(2*k),&u[0],used_length(&u[0],L),1);
+  add_mul_into(r+(3*k),(2*n)-(3*k),&v[0],used_length(&v[0],L),1);
+}
 
-      if(carry == 1) { ans.ripple_carry(t_depth+j); }     
+// r[0..na+nb) = a * b, where r is initially zero
+static void mul_arrays(bui_word_t *r, bui_word_t const *a, uint32_t na, bui_word_t const *b, uint32_t nb) {
+  if(na < nb) { std::swap(a,b); std::swap(na,nb); }
+  if(nb < BUI_KARATSUBA_THRESHOLD) {
+    mul_schoolbook(r,a,na,b,nb);
+  } else if(na > nb) {
+    // split a into pieces of length nb, so each product is balanced
+    std::vector<bui_word_t> tmp(2*nb);
+    for(uint32_t i=0;i<na;i+=nb) {
+      uint32_t len = std::min(nb,na-i);
+      std::fill(tmp.begin(),tmp.end(),0);
+      mul_arrays(&tmp[0],a+i,len,b,nb);
+      add_mul_into(r+i,(na+nb)-i,&tmp[0],len+nb,1);
     }
-    swap(ans);
+  } else if(nb < BUI_TOOM3_THRESHOLD) {
+    mul_karatsuba(r,a,b,nb);
+  } else {
+    mul_toom3(r,a,b,nb);
   }
 }
 
-biguint biguint::operator*(uint32_t w) const {
-  biguint r(*this);
-  r *= w;
-  return r;
+#endif
+
+// the number of words actually used, ignoring any leading zeros
+static uint32_t used_words(bui_word_t const *p) {
+  uint32_t n = p[0];
+  while(n > 1 && p[n+1] == 0) { --n; }
+  return n;
 }
 
 biguint biguint::operator*(biguint const &src) const {
   if((src.ptr & BUI_LEFTMOST_BIT) == 0) { 
-    return (*this) * src.ptr; 
+    biguint r(*this);
+    r.mul_word(src.ptr);
+    return r;
   } else if((ptr & BUI_LEFTMOST_BIT) == 0) { 
-    return src * ptr; 
+    biguint r(src);
+    r.mul_word(ptr);
+    return r;
   } else {
-    uint32_t *s(BUI_UNPACK(src.ptr));
-    uint32_t depth = s[0];
-    biguint ans(0U,depth);
-
-    for(uint32_t j=0;j<depth;++j) {
-      biguint tmp(*this);
-      tmp *= s[j+2];
-      
-      uint32_t *tp(BUI_UNPACK(tmp.ptr));      
-      uint32_t t_depth(tp[0]);
-      uint32_t carry = 0;
-      
-      ans.expand(j + t_depth); 
-      uint32_t *ap(BUI_UNPACK(ans.ptr));      
-
-      // standard add, although slightly modified
-      // to give the base shift for free.
-      for(uint32_t i=0;i!=t_depth;++i) {
-	uint32_t v = ap[j+i+2];
-	uint32_t w = tp[i+2];
-
-	w = v + w + carry;   
-	ap[j+i+2] = w;
-	
-	if(carry == 0) { carry = w < v ? 1 : 0; }
-	else { carry = w <= v ? 1 : 0; }
-      }
-      
-      if(carry == 1) { ans.ripple_carry(t_depth+j); }     
-    }
-
+    bui_word_t *p(BUI_UNPACK(ptr));
+    bui_word_t *s(BUI_UNPACK(src.ptr));
+    uint32_t np = used_words(p);
+    uint32_t ns = used_words(s);
+    uint32_t depth = np + ns;
+    bui_word_t *ap = aligned_alloc(depth+2);
+    memset(ap+2,0,depth*sizeof(bui_word_t));
+    mul_arrays(ap+2,p+2,np,s+2,ns);
+    // the top word may well be zero, which goes to padding
+    uint32_t padding = (ap[depth+1] == 0) ? 1 : 0;
+    ap[0] = depth - padding;
+    ap[1] = padding;
+    biguint ans;
+    ans.ptr = BUI_PACK(ap);
     return ans;
   }
 }
 
+void biguint::operator*=(biguint const &src) {
+  if((src.ptr & BUI_LEFTMOST_BIT) == 0) { 
+    mul_word(src.ptr); 
+  } else {
+    biguint ans((*this) * src);
+    swap(ans);
+  }
+}
+
+biguint biguint::operator*(uint32_t w) const {
+  biguint r(*this);
+  r *= w;
+  return r;
+}
+
 void biguint::operator/=(uint32_t v) {
   if(v == 0) { throw std::runtime_error("divide by zero"); }
   if(ptr & BUI_LEFTMOST_BIT) {
-    uint32_t *p(BUI_UNPACK(ptr));
-    uint32_t remainder=0;
+    bui_word_t *p(BUI_UNPACK(ptr));
+#ifdef BUI_USE_GMP
+    mpn_divrem_1(BUI_LIMBS(p+2),0,BUI_CLIMBS(p+2),p[0],v);
+#else
+    bui_word_t remainder=0;
     
     for(uint32_t i=p[0]+1;i>1;--i) {
-      uint64_t w = remainder;
-      w = (w << 32U) + p[i];
-      p[i] = w / v;
-      remainder = w % v;
+      bui_dword_t w = remainder;
+      w = (w << BUI_WORD_BITS) + p[i];
+      p[i] = (bui_word_t) (w / v);
+      remainder = (bui_word_t) (w % v);
     }    
+#endif
   } else {
     // real easy!
     ptr = ptr / v;
@@ -556,48 +669,43 @@ biguint biguint::operator/(uint32_t w) const {
 }
 
 void biguint::operator%=(uint32_t v) {
-  if(v == 0) { throw std::runtime_error("divide by zero"); }
-  if(ptr & BUI_LEFTMOST_BIT) {
-    uint32_t *p(BUI_UNPACK(ptr));
-    uint32_t remainder=0;
-    
-    for(uint32_t i=p[0]+1;i>1;--i) {
-      uint64_t w = remainder;
-      w = (w << 32U) + p[i];
-      remainder = w % v;
-    }    
-    clone(remainder);
-  } else {
-    ptr = ptr % v;
-  }
+  uint32_t remainder = (*this) % v;
+  if(ptr & BUI_LEFTMOST_BIT) { aligned_free(BUI_UNPACK(ptr)); }
+  clone(remainder);
 }
 
 uint32_t biguint::operator%(uint32_t v) const {
   if(v == 0) { throw std::runtime_error("divide by zero"); }
   if(ptr & BUI_LEFTMOST_BIT) {
-    uint32_t *p(BUI_UNPACK(ptr));
-    uint32_t remainder=0;
+    bui_word_t *p(BUI_UNPACK(ptr));
+#ifdef BUI_USE_GMP
+    return mpn_mod_1(BUI_CLIMBS(p+2),p[0],v);
+#else
+    bui_word_t remainder=0;
   
-   for(uint32_t i=p[0]+1;i>1;--i) {
-     uint64_t w = remainder;
-     w = (w << 32U) + p[i];
-     remainder = w % v;;
-   }     
-   return remainder;
+    for(uint32_t i=p[0]+1;i>1;--i) {
+      bui_dword_t w = remainder;
+      w = (w << BUI_WORD_BITS) + p[i];
+      remainder = (bui_word_t) (w % v);
+    }     
+    return remainder;
+#endif
   } else {
     return ptr % v;
   }
 }
 
 void biguint::operator^=(uint32_t v) {
-  if(v == UINT32_C(0)) { (*this) = UINT32_C(1); }
-  else {
-    biguint p(*this);
-    
-    for(uint32_t i=1;i<v;++i) {
-      (*this) *= p;
-    }
+  // square and multiply, so that the products are balanced (which
+  // is where Karatsuba and Toom-3 help)
+  biguint r(UINT32_C(1));
+  biguint p(*this);
+  while(v != 0) {
+    if(v & 1U) { r *= p; }
+    v >>= 1U;
+    if(v != 0) { p = p * p; }
   }
+  swap(r);
 }
 
 biguint biguint::operator^(uint32_t v) const {
@@ -611,41 +719,127 @@ biguint biguint::operator^(uint32_t v) const {
 /* =============================== */
 
 uint32_t biguint::c_uint32() const {
-  if(ptr & BUI_LEFTMOST_BIT) {
-    uint32_t *p(BUI_UNPACK(ptr));
-    if(p[0] > 1U) { throw runtime_error("biguint too large for uint32_t"); }
-    return p[2];
-  } else {
-    return ptr;
-  }
+  uint64_t r;
+  if(!to_uint64(r) || r > UINT32_MAX) { throw runtime_error("biguint too large for uint32_t"); }
+  return r;
 }  
 
 uint64_t biguint::c_uint64() const {
-  if(ptr & BUI_LEFTMOST_BIT) {
-    uint32_t *p(BUI_UNPACK(ptr));
-    uint32_t depth = p[0];
-    if(depth > 2U) { throw runtime_error("biguint too large for uint64_t"); }
-    uint64_t r=0;
-    for(uint32_t i=depth+1;i>1;--i) {
-      r <<= 32U;
-      r += p[i];
-    }
-    return r;
-  } else {
-    return ptr;
-  }
+  uint64_t r;
+  if(!to_uint64(r)) { throw runtime_error("biguint too large for uint64_t"); }
+  return r;
 }  
 
 /* =============================== */
 /* ======== HELPER METHODS ======= */
 /* =============================== */
 
+// Determine the value as a uint64_t, returning false if it's too
+// large to fit.
+bool biguint::to_uint64(uint64_t &v) const {
+  if((ptr & BUI_LEFTMOST_BIT) == 0) {
+    v = ptr;
+    return true;
+  }
+  bui_word_t *p(BUI_UNPACK(ptr));
+  uint32_t depth = p[0];
+  // the number of words which fit in 64 bits
+  uint32_t n = 64U / BUI_WORD_BITS;
+  for(uint32_t i=n+2;i<(depth+2);++i) {
+    if(p[i] != 0) { return false; }
+  }
+#if BUI_WORD_BITS == 64
+  v = p[2];
+#else
+  v = p[2];
+  if(depth > 1) { v += ((uint64_t) p[3]) << 32U; }
+#endif
+  return true;
+}
+
+void biguint::add_word(bui_word_t w) {
+  if(ptr & BUI_LEFTMOST_BIT) {    
+    bui_word_t *p(BUI_UNPACK(ptr));
+    bui_word_t v = p[2];
+    w = v + w;
+    p[2] = w;
+    if(w < v) { ripple_carry(1); }
+  } else {
+    bui_word_t v = ptr;
+    bui_word_t r = v + w;
+    if(r < v) {
+      bui_word_t *p = aligned_alloc(4); 
+      p[0] = 2U;
+      p[1] = 0;
+      p[2] = r;
+      p[3] = 1U;
+      ptr = BUI_PACK(p);
+    } else {
+      clone_word(r);
+    } 
+  }
+}
+
+void biguint::sub_word(bui_word_t w) {
+  if(ptr & BUI_LEFTMOST_BIT) {    
+    bui_word_t *p(BUI_UNPACK(ptr));    
+    bui_word_t v = p[2];
+    p[2] = v - w;
+    if(v < w) { ripple_borrow(1); }
+  } else {
+    bui_word_t v(ptr);
+    if(v < w) { throw std::runtime_error("biguint cannot go negative"); }
+    ptr = v - w;
+  }
+}
+
+void biguint::mul_word(bui_word_t v) {
+  if(ptr & BUI_LEFTMOST_BIT) {    
+    // complicated case!
+    bui_word_t *p(BUI_UNPACK(ptr));
+    uint32_t depth(p[0]);
+#ifdef BUI_USE_GMP
+    bui_word_t overflow = mpn_mul_1(BUI_LIMBS(p+2),BUI_CLIMBS(p+2),depth,v);
+#else
+    bui_word_t overflow = 0;
+
+    for(uint32_t i=2;i<(depth+2);++i) {
+      bui_dword_t w = (((bui_dword_t) p[i]) * v) + overflow;
+      p[i] = (bui_word_t) w;
+      overflow = (bui_word_t) (w >> BUI_WORD_BITS);
+    }
+#endif
+    
+    if(overflow > 0) {
+      // need additional space
+      expand(depth+1);   
+      p = BUI_UNPACK(ptr); 
+      p[depth+2] = overflow;
+    }
+  } else {    
+    // easier case!
+    bui_dword_t w = ((bui_dword_t) ptr) * v;
+    bui_word_t hi = (bui_word_t) (w >> BUI_WORD_BITS);
+    if(hi != 0) { 
+      // build new object
+      bui_word_t *p = aligned_alloc(4);
+      ptr = BUI_PACK(p);
+      p[0] = 2U;
+      p[1] = 0;
+      p[2] = (bui_word_t) w;
+      p[3] = hi;
+    } else {
+      clone_word((bui_word_t) w);
+    }
+  }
+}
+
 // Expands the array to depth ndepth.  If ndepth < current depth,
 // nothing happens.  
 //
 // PRE: assumes this in array format
 void biguint::expand(uint32_t ndepth) {
-  uint32_t *p(BUI_UNPACK(ptr));
+  bui_word_t *p(BUI_UNPACK(ptr));
   uint32_t depth = p[0];
   uint32_t padding = p[1];
   if(depth >= ndepth) { return; }
@@ -654,25 +848,25 @@ void biguint::expand(uint32_t ndepth) {
     p[0] = ndepth;
     p[1] = (depth+padding)-ndepth;
   } else {
-    uint32_t *nptr = aligned_alloc((ndepth*2)+2);
+    bui_word_t *nptr = aligned_alloc((ndepth*2)+2);
     nptr[0]=ndepth;
     nptr[1]=ndepth;
 
-    memset(nptr+depth+2,0,((ndepth*2)-depth)*sizeof(uint32_t));
-    memcpy(nptr+2, p+2, depth*sizeof(uint32_t));
-    free(p);
+    memset(nptr+depth+2,0,((ndepth*2)-depth)*sizeof(bui_word_t));
+    memcpy(nptr+2, p+2, depth*sizeof(bui_word_t));
+    aligned_free(p);
     ptr = BUI_PACK(nptr);
   }
 }
 
 void biguint::ripple_carry(uint32_t level) {
-  uint32_t *p(BUI_UNPACK(ptr));
+  bui_word_t *p(BUI_UNPACK(ptr));
   uint32_t depth(p[0]);
 
   for(uint32_t i(level+2);i<(depth+2);++i) {
-    uint32_t v = p[i];
+    bui_word_t v = p[i];
     
-    if(v == UINT32_MAX) { p[i] = 0; } 
+    if(v == BUI_WORD_MAX) { p[i] = 0; } 
     else {
       p[i] = v + 1;
       return;
@@ -684,12 +878,12 @@ void biguint::ripple_carry(uint32_t level) {
 }
 
 void biguint::ripple_borrow(uint32_t level) {  
-  uint32_t *p(BUI_UNPACK(ptr));
+  bui_word_t *p(BUI_UNPACK(ptr));
   uint32_t depth = p[0];
   for(uint32_t i(level+2);i<(depth+2);++i) {
-    uint32_t v = p[i];
+    bui_word_t v = p[i];
     if(v == 0) {
-      p[i] = UINT32_MAX;
+      p[i] = BUI_WORD_MAX;
     } else {
       p[i] = v - 1;
       return;
@@ -699,30 +893,116 @@ void biguint::ripple_borrow(uint32_t level) {
   throw std::runtime_error("biguint cannot go negative"); 
 }
 
-uint32_t *biguint::aligned_alloc(uint32_t c) {
-  uint32_t *p = (uint32_t*) malloc(c * sizeof(uint32_t));  
+bui_word_t *biguint::aligned_alloc(uint32_t c) {
+  if(c <= BUI_POOL_WORDS) {
+    bui_word_t *p = pool[c];
+    if(p == NULL) { return pool_alloc(c); }
+    memcpy(&pool[c],p,sizeof(bui_word_t*));
+    return p;
+  }
+  bui_word_t *p = (bui_word_t*) malloc(c * sizeof(bui_word_t));  
   if(p == NULL) { throw std::bad_alloc(); }
   if(((uint32_ptr_t)p) & 1U) { throw std::runtime_error("Allocated memory not aligned!"); }
   return p;
 }
 
 /* =============================== */
-/* ======== FRIEND METHODS ======= */
+/* ========= ARRAY POOL ========== */
 /* =============================== */
 
-std::ostream& operator<<(ostream &out, biguint val) {
-  std::string r;
+// Small arrays are carved out of chunks of this many words, which are
+// never given back.  Once freed, an array goes onto the free list for
+// its size (see aligned_free), and the next array of that size reuses
+// it.  Thus, the pool only grows to the most arrays of each size ever
+// live at once.
+#define BUI_POOL_CHUNK 16384U
 
-  if(val == UINT32_C(0)) { return out << "0"; }
-  
-  while(val != UINT32_C(0)) {
-    uint32_t digit = val % 10;
-    char d = digit + '0'; // YUK
-    r = d + r;
-    val = val / 10;
+bui_word_t *biguint::pool[BUI_POOL_WORDS+1];
+
+static bui_word_t *pool_chunk = NULL;
+static uint32_t pool_left = 0;
+
+bui_word_t *biguint::pool_alloc(uint32_t c) {
+  if(pool_left < c) {
+    // what remains of the old chunk is still good for a smaller array
+    if(pool_left >= 3) {
+      memcpy(pool_chunk,&pool[pool_left],sizeof(bui_word_t*));
+      pool[pool_left] = pool_chunk;
+    }
+    pool_chunk = (bui_word_t*) malloc(BUI_POOL_CHUNK * sizeof(bui_word_t));
+    if(pool_chunk == NULL) { pool_left = 0; throw std::bad_alloc(); }
+    pool_left = BUI_POOL_CHUNK;
   }
+  bui_word_t *p = pool_chunk;
+  pool_chunk += c;
+  pool_left -= c;
+  return p;
+}
+
+/* =============================== */
+/* ======== FRIEND METHODS ======= */
+/* =============================== */
 
-  return out << r;
+// The largest power of ten which fits in a word, and its exponent
+#if BUI_WORD_BITS == 64
+#define BUI_DECIMAL_BASE UINT64_C(10000000000000000000)
+#define BUI_DECIMAL_DIGITS 19
+#else
+#define BUI_DECIMAL_BASE UINT32_C(1000000000)
+#define BUI_DECIMAL_DIGITS 9
+#endif
+
+// The decimal digits are produced a word at a time, from the least
+// significant end, by repeatedly dividing a copy of the value by
+// BUI_DECIMAL_BASE.  This needs one pass over the value for every
+// BUI_DECIMAL_DIGITS digits, rather than one per digit, and the digits
+// go straight into a single buffer.
+std::ostream& operator<<(ostream &out, biguint const &val) {
+  if((val.ptr & BUI_LEFTMOST_BIT) == 0) { return out << (bui_word_t) val.ptr; }
+
+  bui_word_t *p(BUI_UNPACK(val.ptr));
+  std::vector<bui_word_t> ws(p+2,p+2+p[0]);
+  uint32_t n = used_length(&ws[0],ws.size());
+  // each word gives fewer than BUI_DECIMAL_DIGITS+1 digits
+  std::vector<char> buf((ws.size() * (BUI_DECIMAL_DIGITS+1)) + 1);
+  char *end = &buf[0] + buf.size();
+  char *pos = end;
+
+#ifdef BUI_USE_GMP
+  // GMP does this in subquadratic time, leaving digit values (not
+  // characters) at the front of the buffer
+  if(n > 0) {
+    pos = &buf[0];
+    end = pos + mpn_get_str((unsigned char *) pos,10,BUI_LIMBS(&ws[0]),n);
+    for(char *i=pos;i!=end;++i) { *i += '0'; }
+  }
+#else
+  while(n > 0) {
+    bui_word_t chunk = 0;
+    for(uint32_t i=n;i>0;--i) {
+      bui_dword_t w = (((bui_dword_t) chunk) << BUI_WORD_BITS) + ws[i-1];
+      ws[i-1] = (bui_word_t) (w / BUI_DECIMAL_BASE);
+      chunk = (bui_word_t) (w % BUI_DECIMAL_BASE);
+    }
+    n = used_length(&ws[0],n);
+    // every chunk but the most significant has leading zeros
+    uint32_t d = 0;
+    do {
+      *--pos = '0' + (chunk % 10);
+      chunk /= 10;
+      ++d;
+    } while(n != 0 ? d < BUI_DECIMAL_DIGITS : chunk != 0);
+  }
+#endif
+  if(pos == end) { *--pos = '0'; }
+
+  if(out.width() == 0) {
+    out.write(pos,end-pos);
+  } else {
+    // respect any field width set
+    out << std::string(pos,end);
+  }
+  return out;
 }
 
 biguint pow(biguint const &r, uint32_t power) {
@@ -731,13 +1011,14 @@ biguint pow(biguint const &r, uint32_t power) {
 
 bstreambuf &operator<<(bstreambuf &bout, biguint const &src) {
   if(src.ptr & BUI_LEFTMOST_BIT) {
-    uint32_t *s(BUI_UNPACK(src.ptr));
+    bui_word_t *s(BUI_UNPACK(src.ptr));
     uint32_t depth(s[0]);
     bout << depth;
     for(uint32_t i=2;i<(depth+2);++i) { bout << s[i]; }
   } else {
-    bout << 1U << (uint32_t) src.ptr;
+    bout << 1U << (bui_word_t) src.ptr;
   }
+  return bout;
 }
 
 bistream &operator>>(bistream &bin, biguint &src) {  
@@ -745,22 +1026,20 @@ bistream &operator>>(bistream &bin, biguint &src) {
 
   bin >> depth;
   if(depth == 1) {
-    uint32_t v;
+    bui_word_t v;
     bin >> v;
-    biguint tmp(v);
+    biguint tmp;
+    tmp.clone_word(v);
     src.swap(tmp);
   } else {  
-    // inlined align_alloc
-    uint32_t *ptr = (uint32_t*) malloc(((2*depth)+2) * sizeof(uint32_t));  
-    if(ptr == NULL) { throw std::bad_alloc(); }
-    if(((uint32_ptr_t)ptr) & 1U) { throw std::runtime_error("Allocated memory not aligned!"); }
-    
+    bui_word_t *ptr = biguint::aligned_alloc((2*depth)+2);
+
     ptr[0] = depth;
     ptr[1] = depth;
     // copy data
     for(uint32_t i=2;i<(depth+2);++i) { bin >> ptr[i]; }
     // clear padding zeros
-    memset(ptr+2+depth,0,depth*sizeof(uint32_t));
+    memset(ptr+2+depth,0,depth*sizeof(bui_word_t));
 
     biguint tmp;
     tmp.ptr = BUI_PACK(ptr);
@@ -11,6 +11,8 @@
 
 #include <iostream>
 #include <climits>
+#include <cstdlib>
+#include <cstring>
 #include <stdint.h>
 
 #include "../../config.h"
@@ -25,7 +27,14 @@
 #define UINT32_C(x) ((uint32_t)x)
 #endif
 
-#define BUI_LEFTMOST_32BIT (1U << 31U)
+// Move construction and assignment need C++11; without it, values
+// are simply copied.
+#if __cplusplus >= 201103L
+#define BUI_MOVE_SEMANTICS
+#define BUI_NOEXCEPT noexcept
+#else
+#define BUI_NOEXCEPT throw()
+#endif
 
 #if SIZEOF_UNSIGNED_INT_P==4
 #define BUI_LEFTMOST_BIT (1U << 31U)
@@ -39,8 +48,36 @@ typedef uint64_t uint32_ptr_t;
 #error "sizeof(int*) is neither 32bit or 64bit."
 #endif
 
+// The digits (or limbs) of a biguint are words of the same width as a
+// pointer, wherever there is an integer type twice that width to hold
+// the result of adding or multiplying two of them.  Thus, on 64-bit
+// machines, each step of a carry or multiply loop handles twice as
+// many bits.  Defining BUI_32BIT_WORDS forces 32-bit words, which is
+// useful for comparison.
+#if SIZEOF_UNSIGNED_INT_P==8 && defined(__SIZEOF_INT128__) && !defined(BUI_32BIT_WORDS)
+typedef uint64_t bui_word_t;
+__extension__ typedef unsigned __int128 bui_dword_t;
+#define BUI_WORD_BITS 64U
+#else
+typedef uint32_t bui_word_t;
+typedef uint64_t bui_dword_t;
+#define BUI_WORD_BITS 32U
+#endif
+
+#define BUI_WORD_MAX ((bui_word_t) -1)
+// values below this are held inline (i.e. in ptr), rather than in an array
+#define BUI_LEFTMOST_WORD (((bui_word_t)1U) << (BUI_WORD_BITS-1U))
+
+// Arrays of up to this many words (including the two header words)
+// are recycled through a free list for each size, rather than being
+// handed back to malloc.  Coefficients are created and destroyed at a
+// great rate during the computation, and most of them are small.
+#ifndef BUI_POOL_WORDS
+#define BUI_POOL_WORDS 32U
+#endif
+
 #define BUI_PACK(x) ((((uint32_ptr_t)x) >> 1U) | BUI_LEFTMOST_BIT)
-#define BUI_UNPACK(x) ((uint32_t*)(x << 1U))
+#define BUI_UNPACK(x) ((bui_word_t*)(x << 1U))
 
 
 class biguint {
@@ -54,15 +91,15 @@ public:
   /* ========= CONSTRUCTORS ======== */
   /* =============================== */
 
-private:
-  biguint(uint32_t v, uint32_t d);
-
 public:
   inline biguint() { ptr = 0U; }  
   inline biguint(uint32_t v) { clone(v); }
   inline biguint(uint64_t v) { clone(v); }
   inline biguint(biguint const &src) { clone(src); }  
-  inline ~biguint() { if(ptr & BUI_LEFTMOST_BIT) { free(BUI_UNPACK(ptr)); } }
+#ifdef BUI_MOVE_SEMANTICS
+  inline biguint(biguint &&src) BUI_NOEXCEPT : ptr(src.ptr) { src.ptr = 0U; }
+#endif
+  inline ~biguint() { if(ptr & BUI_LEFTMOST_BIT) { aligned_free(BUI_UNPACK(ptr)); } }
 
 
   /* =============================== */
@@ -70,13 +107,13 @@ public:
   /* =============================== */
   
   inline biguint const &operator=(uint32_t v) {
-    if(ptr & BUI_LEFTMOST_BIT) { free(BUI_UNPACK(ptr)); }
+    if(ptr & BUI_LEFTMOST_BIT) { aligned_free(BUI_UNPACK(ptr)); }
     clone(v);
     return *this;
   }
   
   inline biguint const &operator=(uint64_t v) {
-    if(ptr & BUI_LEFTMOST_BIT) { free(BUI_UNPACK(ptr)); }
+    if(ptr & BUI_LEFTMOST_BIT) { aligned_free(BUI_UNPACK(ptr)); }
     clone(v);
     return *this;
   }
@@ -85,8 +122,8 @@ public:
     if(this != &src) {
       if(src.ptr & BUI_LEFTMOST_BIT) {
 	if(ptr & BUI_LEFTMOST_BIT) {
-	  uint32_t *s = BUI_UNPACK(src.ptr);
-	  uint32_t *p = BUI_UNPACK(ptr);
+	  bui_word_t *s = BUI_UNPACK(src.ptr);
+	  bui_word_t *p = BUI_UNPACK(ptr);
 	  // attempt to reuse memory where possible.
 	  uint32_t src_depth = s[0];
 	  uint32_t depth = p[0];
@@ -96,17 +133,17 @@ public:
 	    padding = ((depth+padding)-src_depth);
 	    p[0] = src_depth;
 	    p[1] = padding;
-	    memcpy(p+2,s+2,(src_depth)*sizeof(uint32_t));
-	    memset(p+src_depth+2,0,padding*sizeof(uint32_t));
+	    memcpy(p+2,s+2,(src_depth)*sizeof(bui_word_t));
+	    memset(p+src_depth+2,0,padding*sizeof(bui_word_t));
 	  } else {	  
-	    free(BUI_UNPACK(ptr));
+	    aligned_free(BUI_UNPACK(ptr));
 	    clone(src);
 	  }
 	} else {
 	  clone(src);
 	}	
       } else {
-	if(ptr & BUI_LEFTMOST_BIT) { free(BUI_UNPACK(ptr)); };
+	if(ptr & BUI_LEFTMOST_BIT) { aligned_free(BUI_UNPACK(ptr)); };
 	ptr = src.ptr;
       }
     }
@@ -114,7 +151,18 @@ public:
     return *this;
   }
 
-  inline void swap(biguint &src) {
+#ifdef BUI_MOVE_SEMANTICS
+  inline biguint const &operator=(biguint &&src) BUI_NOEXCEPT {
+    if(this != &src) {
+      if(ptr & BUI_LEFTMOST_BIT) { aligned_free(BUI_UNPACK(ptr)); }
+      ptr = src.ptr;
+      src.ptr = 0U;
+    }
+    return *this;
+  }
+#endif
+
+  inline void swap(biguint &src) BUI_NOEXCEPT {
     std::swap(ptr,src.ptr);
   }
 
@@ -155,6 +203,7 @@ public:
 
   void operator-=(uint32_t w);
   void operator-=(biguint const &src);
+  void sub_from(biguint const &src);
 
   void operator*=(uint32_t v);
   void operator*=(biguint const &v);
@@ -187,25 +236,33 @@ public:
   
 private:
   inline void clone(uint32_t v) {
-    if(v >= BUI_LEFTMOST_32BIT) {
-      uint32_t *p = aligned_alloc(3);
+    clone_word(v);
+  }
+
+  inline void clone(uint64_t v) {
+#if BUI_WORD_BITS == 64
+    clone_word(v);
+#else
+    if(v >= BUI_LEFTMOST_WORD) {
+      bui_word_t *p = aligned_alloc(4);
       ptr = BUI_PACK(p);
-      p[0] = 1;
+      p[0] = 2;
       p[1] = 0;
       p[2] = v;
+      p[3] = v >> 32U;
     } else {
       ptr = v;
     }
+#endif
   }
 
-  inline void clone(uint64_t v) {
-    if(v >= BUI_LEFTMOST_32BIT) {
-      uint32_t *p = aligned_alloc(4);
+  inline void clone_word(bui_word_t v) {
+    if(v >= BUI_LEFTMOST_WORD) {
+      bui_word_t *p = aligned_alloc(3);
       ptr = BUI_PACK(p);
-      p[0] = 2;
+      p[0] = 1;
       p[1] = 0;
       p[2] = v;
-      p[3] = v >> 32U;
     } else {
       ptr = v;
     }
@@ -213,21 +270,42 @@ private:
 
   inline void clone(biguint const &src) {
     if(src.ptr & BUI_LEFTMOST_BIT) {
-      uint32_t *s = BUI_UNPACK(src.ptr);
+      bui_word_t *s = BUI_UNPACK(src.ptr);
       uint32_t depth = s[0];
       uint32_t padding = s[1];
-      uint32_t *p = aligned_alloc(depth+padding+2);
+      bui_word_t *p = aligned_alloc(depth+padding+2);
       p[0] = depth;
       p[1] = padding;
-      memcpy(p+2,s+2,(padding+depth)*sizeof(uint32_t));
+      memcpy(p+2,s+2,(padding+depth)*sizeof(bui_word_t));
       ptr = BUI_PACK(p);
     } else {
       ptr = src.ptr;
     }
   }
 
+  bool to_uint64(uint64_t &v) const;
+
+  void add_word(bui_word_t w);
+  void sub_word(bui_word_t w);
+  void mul_word(bui_word_t v);
+
   void expand(uint32_t ndepth);
-  uint32_t *aligned_alloc(uint32_t c);
+  static bui_word_t *aligned_alloc(uint32_t c);
+  static bui_word_t *pool_alloc(uint32_t c);
+
+  // The size of an array is always depth + padding + 2, so it need
+  // not be stored separately.
+  static inline void aligned_free(bui_word_t *p) {
+    uint32_t c = p[0] + p[1] + 2;
+    if(c <= BUI_POOL_WORDS) {
+      memcpy(p,&pool[c],sizeof(bui_word_t*));
+      pool[c] = p;
+    } else {
+      free(p);
+    }
+  }
+
+  static bui_word_t *pool[BUI_POOL_WORDS+1];
 
   void ripple_carry(uint32_t level);
   void ripple_borrow(uint32_t level);
@@ -237,7 +315,7 @@ private:
 /* ======== OTHER USEFUL METHODS ======= */
 /* ===================================== */
 
-std::ostream& operator<<(std::ostream &out, biguint val);
+std::ostream& operator<<(std::ostream &out, biguint const &val);
 bstreambuf &operator<<(bstreambuf &, biguint const &);
 bistream &operator>>(bistream &, biguint &);
 biguint pow(biguint const &r, uint32_t power);
@@ -0,0 +1,172 @@
+// (C) Copyright David James Pearce and Gary Haggard, 2007.
+// Permission to copy, use, modify, sell and distribute this software
+// is granted provided this copyright notice appears in all copies.
+// This software is provided "as is" without express or implied
+// warranty, and with no claim as to its suitability for any purpose.
+//
+// Email: david.pearce@mcs.vuw.ac.nz
+
+// Throughput benchmark for biguint arithmetic.  Each operation is
+// timed on values of 64 to 2048 bits, which covers the coefficients
+// of the larger Tutte polynomials.  Building a second copy with
+// -DBUI_32BIT_WORDS gives the same figures for 32-bit words.  The
+// second part times products of two equal sized values, up to much
+// larger sizes, which is what BUI_KARATSUBA_THRESHOLD and
+// BUI_TOOM3_THRESHOLD are chosen from (by rebuilding with each set to
+// different values).  To build (in a configured tree):
+//
+//   g++ -O2 biguint_bench.cpp biguint.cpp bstreambuf.cpp bistream.cpp -o biguint_bench
+//   ./biguint_bench
+//
+// In a tree configured --with-gmp, add -lgmp to get the same figures
+// for the GMP kernels (the thresholds then play no part).
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <sstream>
+#include <cstdlib>
+#include <sys/time.h>
+#include "biguint.hpp"
+
+using namespace std;
+
+double now() {
+  struct timeval tmp;
+  gettimeofday(&tmp,NULL);
+  return tmp.tv_sec + (tmp.tv_usec / 1000000.0);
+}
+
+// a random value of the given number of bits
+biguint random_biguint(unsigned int bits) {
+  biguint r(UINT32_C(1));
+  while(bits > 16) {
+    r *= UINT32_C(1) << 16U;
+    r += (uint32_t) (rand() & 0xffff);
+    bits -= 16;
+  }
+  return r;
+}
+
+#define NVALUES 64
+
+// these are only for reporting; the thresholds are set in biguint.cpp
+#ifdef BUI_KARATSUBA_THRESHOLD
+#define BUI_KARATSUBA_THRESHOLD_BENCH BUI_KARATSUBA_THRESHOLD
+#else
+#define BUI_KARATSUBA_THRESHOLD_BENCH "default"
+#endif
+#ifdef BUI_TOOM3_THRESHOLD
+#define BUI_TOOM3_THRESHOLD_BENCH BUI_TOOM3_THRESHOLD
+#else
+#define BUI_TOOM3_THRESHOLD_BENCH "default"
+#endif
+
+// the operations timed, each applied across a table of values
+typedef enum { ADD, SUB, MULWORD, MUL, DIVWORD, COPY, PRINT } bop;
+
+char const *bop_names[] = { "a += b", "a -= b", "a * w", "a * b", "a / w", "a = b", "out << a" };
+
+double run(bop op, vector<biguint> &as, vector<biguint> const &bs) {
+  unsigned int reps = 0;
+  biguint sink(UINT32_C(0));
+  double start = now(), end;
+  do {
+    for(unsigned int i=0;i!=NVALUES;++i) {
+      switch(op) {
+      case ADD:
+	as[i] += bs[i];
+	break;
+      case SUB:
+	as[i] -= bs[i];
+	break;
+      case MULWORD:
+	sink = as[i] * UINT32_C(0x9e3779b1);
+	break;
+      case MUL:
+	sink = as[i] * bs[i];
+	break;
+      case DIVWORD:
+	sink = as[i] / UINT32_C(0x9e3779b1);
+	break;
+      case COPY:
+	as[i] = bs[i];
+	break;
+      case PRINT: {
+	std::ostringstream out;
+	out << as[i];
+	break;
+      }
+      }
+    }
+    ++reps;
+    end = now();
+  } while(end - start < 0.2);
+  return ((end - start) * 1e9) / (reps * NVALUES);
+}
+
+// check a product modulo a few primes, since a mistake in the carries
+// (or the interpolation) is unlikely to survive this
+bool check_product(biguint const &a, biguint const &b, biguint const &r) {
+  uint32_t primes[] = { 1000003U, 2147483647U, 4294967291U };
+  for(unsigned int i=0;i!=3;++i) {
+    uint64_t p = primes[i];
+    uint64_t ap = a % primes[i], bp = b % primes[i];
+    if((r % primes[i]) != (ap * bp) % p) { return false; }
+  }
+  return true;
+}
+
+void bench_balanced() {
+  cout << "balanced products (karatsuba threshold " << BUI_KARATSUBA_THRESHOLD_BENCH
+       << ", toom-3 threshold " << BUI_TOOM3_THRESHOLD_BENCH << " words), ns per operation" << endl;
+  cout << setw(8) << "bits" << setw(12) << "a * b" << endl;
+  for(unsigned int bits=512;bits<=65536;bits+=bits/2) {
+    vector<biguint> as, bs;
+    unsigned int n = std::max(4U,(NVALUES * 1024U) / bits);
+    for(unsigned int i=0;i!=n;++i) {
+      as.push_back(random_biguint(bits));
+      bs.push_back(random_biguint(bits));
+      if(!check_product(as[i],bs[i],as[i] * bs[i])) {
+	cout << "ERROR: incorrect product for " << bits << " bits" << endl;
+	exit(1);
+      }
+    }
+    unsigned int reps = 0;
+    biguint sink(UINT32_C(0));
+    double start = now(), end;
+    do {
+      for(unsigned int i=0;i!=n;++i) { sink = as[i] * bs[i]; }
+      ++reps;
+      end = now();
+    } while(end - start < 0.2);
+    cout << setw(8) << bits << setw(12) << setprecision(4) << ((end - start) * 1e9) / (reps * n) << endl;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  srand(1);
+  cout << "biguint (" << BUI_WORD_BITS << "-bit words), ns per operation" << endl;
+  cout << setw(8) << "bits";
+  for(unsigned int op=ADD;op<=PRINT;++op) { cout << setw(10) << bop_names[op]; }
+  cout << endl;
+  for(unsigned int bits=64;bits<=2048;bits*=2) {
+    vector<biguint> as, bs;
+    for(unsigned int i=0;i!=NVALUES;++i) {
+      bs.push_back(random_biguint(bits));
+    }
+    cout << setw(8) << bits;
+    for(unsigned int op=ADD;op<=PRINT;++op) {
+      // a is kept larger than b, so that subtraction never goes
+      // negative, and is reset for each operation since addition and
+      // subtraction change it.
+      as.clear();
+      for(unsigned int i=0;i!=NVALUES;++i) {
+	as.push_back(bs[i] * random_biguint(bits));
+      }
+      cout << setw(10) << setprecision(3) << run((bop) op,as,bs);
+    }
+    cout << endl;
+  }
+  bench_balanced();
+}
@@ -1,4 +1,5 @@
 #include <iostream>
+#include <sstream>
 #include <cstdlib>
 #include <getopt.h>
 #include <time.h>
@@ -152,6 +153,88 @@ void commutative_add_test(uint32_t count, uint32_t length) {
   }
 }
 
+// a random value with the given number of (32-bit) words
+biguint random_biguint(uint32_t length) {
+  biguint r(random_word());
+  for(uint32_t j=1;j<length;++j) {
+    r *= UINT32_C(1) << 16U;
+    r *= UINT32_C(1) << 16U;
+    r += random_word();
+  }
+  return r;
+}
+
+// Check the arithmetic identities on values spanning many words, so
+// that the carries between words are exercised.
+void big_test(uint32_t count, uint32_t length) {
+  for(uint32_t i=0;i!=count;++i) {
+    biguint a(random_biguint(1+(rand() % length)));
+    biguint b(random_biguint(1+(rand() % length)));
+    biguint c(random_biguint(1+(rand() % length)));
+    uint32_t w(random_word() | 1U);
+    uint32_t r(random_word() % w);
+
+    if(a * b != b * a) {
+      cout << "ERROR(1): " << a << " * " << b << " gives " << (a*b) << ", but reversed gives " << (b*a) << endl;
+    } else if((a + b) * c != (a * c) + (b * c)) {
+      cout << "ERROR(2): (" << a << " + " << b << ") * " << c << " gives " << ((a+b)*c) << endl;
+    } else if(((a * b) + c) - c != a * b) {
+      cout << "ERROR(3): " << a << " * " << b << " + " << c << " - " << c << " gives " << (((a*b)+c)-c) << endl;
+    } else if(((a * w) + r) / w != a || ((a * w) + r) % w != r) {
+      cout << "ERROR(4): (" << a << " * " << w << " + " << r << ") / " << w << " gives " << (((a*w)+r)/w) << endl;
+    } else if(!(a < a + b + UINT32_C(1)) || !(a + b + UINT32_C(1) > a) || a + b < b) {
+      cout << "ERROR(5): " << a << " < " << a << " + " << b << " + 1 fails" << endl;
+    }
+
+    bstreambuf bout;
+    bout << a;
+    bistream bin(bout);
+    bin >> b;
+    if(a != b) {
+      cout << "ERROR(6): " << a << " read back as " << b << endl;
+    }
+
+    // the decimal digits must give back the same value
+    ostringstream out;
+    out << a;
+    string digits(out.str());
+    biguint d(UINT32_C(0));
+    for(uint32_t j=0;j!=digits.size();++j) {
+      d *= UINT32_C(10);
+      d += (uint32_t) (digits[j] - '0');
+    }
+    if(d != a || (digits.size() > 1 && digits[0] == '0')) {
+      cout << "ERROR(7): " << a << " printed as " << digits << endl;
+    }
+  }
+}
+
+string decimal(biguint const &v) {
+  ostringstream out;
+  out << v;
+  return out.str();
+}
+
+// Check the decimal conversion around powers of ten, since these are
+// where the chunks it works in meet.
+void decimal_test() {
+  biguint p(UINT32_C(1));
+  for(uint32_t k=0;k!=100;++k) {
+    if(decimal(p) != "1" + string(k,'0')) {
+      cout << "ERROR: 10^" << k << " printed as " << decimal(p) << endl;
+    } else if(k > 0 && decimal(p - UINT32_C(1)) != string(k,'9')) {
+      cout << "ERROR: 10^" << k << "-1 printed as " << decimal(p - UINT32_C(1)) << endl;
+    }
+    p *= UINT32_C(10);
+  }
+  // zero, but held as an array
+  biguint z(random_biguint(5));
+  z -= biguint(z);
+  if(decimal(z) != "0") {
+    cout << "ERROR: zero printed as " << decimal(z) << endl;
+  }
+}
+
 void primitive_test(uint32_t count, aop op) {
   for(uint32_t i=0;i!=count;++i) {
     uint32_t w1(random_word());
@@ -250,4 +333,11 @@ int main(int argc, char *argv[]) {
   cout << "COMP <, >= DONE" << endl;
   comparator_test(count,LTEQ);
   cout << "COMP <=, > DONE" << endl;
+  big_test(count,20);
+  cout << "BIG DONE" << endl;
+  decimal_test();
+  cout << "DECIMAL DONE" << endl;
+  // long enough for Karatsuba and Toom-3 to be used
+  big_test(count/100,1000);
+  cout << "BIG (LONG) DONE" << endl;
 }
@@ -109,6 +109,15 @@ public:
     read_ptr += sizeof(long long);   
   }
 
+  // read n raw bytes
+  void read_bytes(void *dst, unsigned int n) {
+    if((read_ptr+n) > end) {
+      throw std::runtime_error("attempt to read past end of stream!");
+    }
+    memcpy(dst,read_ptr,n);
+    read_ptr += n;
+  }
+
   void read(unsigned long long& v) {    
     if((read_ptr+sizeof(unsigned long long)) > end) {
       throw std::runtime_error("attempt to read past end of stream!");
@@ -55,6 +55,7 @@ public:
       write_ptr = start + src.size();
       memcpy(start,src.start,src.size());      
     }
+    return *this;
   }
 
   void reset() { write_ptr = start; }
@@ -150,6 +151,15 @@ public:
     write_ptr += sizeof(long long);
   }
 
+  // write n raw bytes
+  void write_bytes(void const *src, unsigned int n) {
+    if((size()+n) > max()) {
+      resize(size() + n);
+    }
+    memcpy(write_ptr,src,n);
+    write_ptr += n;
+  }
+
   unsigned int size() const { return write_ptr-start; }
   unsigned int max() const { return end-start; }
   unsigned char const * const c_ptr() const { return start; }
@@ -0,0 +1,145 @@
+// (C) Copyright David James Pearce and Gary Haggard, 2007.
+// Permission to copy, use, modify, sell and distribute this software
+// is granted provided this copyright notice appears in all copies.
+// This software is provided "as is" without express or implied
+// warranty, and with no claim as to its suitability for any purpose.
+//
+// Email: david.pearce@mcs.vuw.ac.nz
+
+#ifndef FIXED_UINT_HPP
+#define FIXED_UINT_HPP
+
+#include <iostream>
+#include <vector>
+#include <stdint.h>
+
+#include "bstreambuf.hpp"
+#include "bistream.hpp"
+#include "biguint.hpp"
+
+/**
+ * A fixed_uint is an unsigned integer of fixed width (given by W,
+ * which is either uint64_t or unsigned __int128).  Arithmetic wraps
+ * around, and so is exact modulo 2^w.  Thus, a computation whose final
+ * values are known to be below 2^w can be done entirely with
+ * fixed_uints (even if intermediate values wrap), and never allocates.
+ * The exact values are then recovered by converting to biguint.
+ */
+
+template<class W>
+class fixed_uint {
+private:
+  W value;
+
+  template<class V>
+  friend bstreambuf &operator<<(bstreambuf &, fixed_uint<V> const &);
+  template<class V>
+  friend bistream &operator>>(bistream &, fixed_uint<V> &);
+public:
+  /* =============================== */
+  /* ========= CONSTRUCTORS ======== */
+  /* =============================== */
+
+  fixed_uint() : value(0) {}
+
+  fixed_uint(uint32_t v) : value(v) {}
+
+  // takes v mod 2^w
+  fixed_uint(biguint const &v) {
+    if(v <= (uint64_t) 0xffffffffffffffffULL) {
+      value = v.c_uint64();
+    } else {
+      // break v into base 2^31 digits, and then use Horner's rule
+      biguint tmp(v);
+      uint32_t base = UINT32_C(1) << 31U;
+      std::vector<uint32_t> digits;
+      while(tmp != UINT32_C(0)) {
+	digits.push_back(tmp % base);
+	tmp /= base;
+      }
+      value = 0;
+      for(unsigned int i=digits.size();i>0;--i) {
+	value = (value * base) + digits[i-1];
+      }
+    }
+  }
+
+  /* =============================== */
+  /* ======== ARITHMETIC OPS ======= */
+  /* =============================== */
+
+  void operator+=(uint32_t v) { value += v; }
+  void operator+=(fixed_uint<W> const &v) { value += v.value; }
+  void operator-=(uint32_t v) { value -= v; }
+  void operator-=(fixed_uint<W> const &v) { value -= v.value; }
+  void operator*=(fixed_uint<W> const &v) { value *= v.value; }
+  void operator*=(biguint const &v) { value *= fixed_uint<W>(v).value; }
+
+  fixed_uint<W> operator+(fixed_uint<W> const &v) const {
+    fixed_uint<W> r(*this);
+    r += v;
+    return r;
+  }
+
+  fixed_uint<W> operator-(fixed_uint<W> const &v) const {
+    fixed_uint<W> r(*this);
+    r -= v;
+    return r;
+  }
+
+  fixed_uint<W> operator*(fixed_uint<W> const &v) const {
+    fixed_uint<W> r(*this);
+    r *= v;
+    return r;
+  }
+
+  /* =============================== */
+  /* ======== COMPARISON OPS ======= */
+  /* =============================== */
+
+  bool operator==(uint32_t v) const { return value == v; }
+  bool operator!=(uint32_t v) const { return value != v; }
+
+  /* =============================== */
+  /* ======== CONVERSION OPS ======= */
+  /* =============================== */
+
+  W c_word() const { return value; }
+
+  operator biguint() const {
+    // build from 32-bit pieces, most significant first
+    biguint r(UINT32_C(0));
+    for(int i=sizeof(W)/sizeof(uint32_t);i>0;--i) {
+      r *= biguint((uint64_t) 1 << 32U);
+      r += (uint32_t) (value >> (32U * (i-1)));
+    }
+    return r;
+  }
+};
+
+template<class W>
+std::ostream &operator<<(std::ostream &out, fixed_uint<W> const &v) {
+  out << biguint(v);
+  return out;
+}
+
+template<class W>
+bstreambuf &operator<<(bstreambuf &bout, fixed_uint<W> const &v) {
+  for(unsigned int i=0;i!=sizeof(W)/sizeof(uint64_t);++i) {
+    bout << (unsigned long long) (v.value >> (64U * i));
+  }
+  return bout;
+}
+
+template<class W>
+bistream &operator>>(bistream &bin, fixed_uint<W> &v) {
+  v.value = 0;
+  for(unsigned int i=0;i!=sizeof(W)/sizeof(uint64_t);++i) {
+    unsigned long long r;
+    bin >> r;
+    v.value |= ((W) r) << (64U * i);
+  }
+  return bin;
+}
+
+#endif
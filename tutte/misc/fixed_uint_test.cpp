@@ -0,0 +1,190 @@
+#include <iostream>
+#include <cstdlib>
+#include <getopt.h>
+#include <time.h>
+
+#include "fixed_uint.hpp"
+
+using namespace std;
+
+typedef enum { ADD, SUB, MUL } aop;
+
+uint32_t random_word() {
+  uint32_t w1 = (uint32_t) (65536.0*rand()/(RAND_MAX+1.0));
+  uint32_t w2 = (uint32_t) (65536.0*rand()/(RAND_MAX+1.0));
+  return (w1 << 16U) + w2;
+}
+
+string op2str(aop op) {
+  if(op == ADD) { return "+"; }
+  else if(op == SUB) { return "-"; }
+  else { return "*"; }
+}
+
+// a random value with the given number of (32-bit) words
+biguint random_biguint(uint32_t length) {
+  biguint r(random_word());
+  for(uint32_t j=1;j<length;++j) {
+    r *= UINT32_C(1) << 16U;
+    r *= UINT32_C(1) << 16U;
+    r += random_word();
+  }
+  return r;
+}
+
+// 2^(32*length)
+biguint power_of_two(uint32_t length) {
+  biguint r(UINT32_C(1));
+  for(uint32_t j=0;j!=length;++j) {
+    r *= UINT32_C(1) << 16U;
+    r *= UINT32_C(1) << 16U;
+  }
+  return r;
+}
+
+// Determine v mod 2^w the long way round, by taking the low base 2^16
+// digits of v.  This is given both as a W and as a biguint.
+template<class W>
+W low_bits(biguint v, biguint &b) {
+  vector<uint32_t> digits;
+  for(unsigned int j=0;j!=sizeof(W)/2;++j) {
+    digits.push_back(v % UINT32_C(65536));
+    v /= UINT32_C(65536);
+  }
+  W r = 0;
+  b = UINT32_C(0);
+  for(unsigned int j=digits.size();j>0;--j) {
+    r = (r << 16U) + digits[j-1];
+    b *= UINT32_C(65536);
+    b += digits[j-1];
+  }
+  return r;
+}
+
+// Check the conversions to and from biguint, for values of every
+// length up to the given number of words (so, for length > 4, values
+// at least 2^64 and at least 2^128 are covered).
+template<class W>
+void conversion_test(uint32_t count, uint32_t length) {
+  for(uint32_t i=0;i!=count;++i) {
+    biguint v(random_biguint(1+(i % length)));
+    biguint b;
+    W w = low_bits<W>(v,b);
+    fixed_uint<W> f(v);
+
+    if(f.c_word() != w) {
+      cout << "ERROR(1): " << v << " converted to " << f << ", not " << b << endl;
+    } else if(biguint(f) != b) {
+      cout << "ERROR(2): " << v << " mod 2^w read back as " << biguint(f) << ", not " << b << endl;
+    } else if(biguint(fixed_uint<W>(b)) != b) {
+      cout << "ERROR(3): " << b << " read back as " << biguint(fixed_uint<W>(b)) << endl;
+    }
+
+    bstreambuf bout;
+    bout << f;
+    bistream bin(bout);
+    fixed_uint<W> g;
+    bin >> g;
+    if(g.c_word() != w) {
+      cout << "ERROR(4): " << f << " streamed back as " << g << endl;
+    }
+  }
+}
+
+// Check that arithmetic on random (multi-word) values agrees with
+// biguint, modulo 2^w.
+template<class W>
+void primitive_test(uint32_t count, uint32_t length, aop op) {
+  // a multiple of 2^w which exceeds any random value
+  biguint Q(power_of_two(length+4));
+  for(uint32_t i=0;i!=count;++i) {
+    biguint a(random_biguint(1+(rand() % length)));
+    biguint b(random_biguint(1+(rand() % length)));
+    uint32_t w(random_word());
+    fixed_uint<W> f1(a), f2(a);
+    biguint r1(a), r2(a);
+
+    if(op == ADD) {
+      f1 += fixed_uint<W>(b);
+      f2 += w;
+      r1 += b;
+      r2 += w;
+    } else if(op == SUB) {
+      f1 -= fixed_uint<W>(b);
+      f2 -= w;
+      r1 += Q;
+      r1 -= b;
+      r2 += Q;
+      r2 -= w;
+    } else if(op == MUL) {
+      f1 *= fixed_uint<W>(b);
+      f2 *= b;
+      r1 *= b;
+      r2 *= b;
+    }
+
+    biguint b1, b2;
+    if(f1.c_word() != low_bits<W>(r1,b1)) {
+      cout << "ERROR(1): " << a << " " << op2str(op) << " " << b << " gives " << f1 << ", not " << b1 << endl;
+    } else if(f2.c_word() != low_bits<W>(r2,b2)) {
+      cout << "ERROR(2): " << a << " " << op2str(op) << " " << (op == MUL ? b : biguint(w)) << " gives " << f2 << ", not " << b2 << endl;
+    }
+  }
+}
+
+int main(int argc, char *argv[]) {
+
+  // ------------------------------
+  // Process command-line arguments
+  // ------------------------------
+
+  #define OPT_HELP 0
+  #define OPT_COUNT 1
+
+  struct option long_options[]={
+    {"help",no_argument,NULL,OPT_HELP},
+    {"count",required_argument,NULL,OPT_COUNT},
+    NULL
+  };
+
+  char *descriptions[]={
+    "        --help                    display this information",
+    " -c     --count=<amount>          number of times to repeat each test",
+    NULL
+  };
+
+  uint32_t count = 10000;
+  uint32_t v;
+
+  while((v=getopt_long(argc,argv,"c:",long_options,NULL)) != -1) {
+    switch(v) {
+    case OPT_HELP:
+      cout << "usage: " << argv[0] << " [options]" << endl;
+      cout << "options:" << endl;
+      for(char **ptr=descriptions;*ptr != NULL; ptr++) {
+	cout << *ptr << endl;
+      }
+      exit(1);
+
+    case 'c':
+    case OPT_COUNT:
+      count = atoi(optarg);
+    }
+  }
+
+  // seed random number generator
+  srand(time(NULL));
+  // do the tests!
+  conversion_test<uint64_t>(count,8);
+  conversion_test<unsigned __int128>(count,8);
+  cout << "CONVERSION DONE" << endl;
+  primitive_test<uint64_t>(count,8,ADD);
+  primitive_test<unsigned __int128>(count,8,ADD);
+  cout << "PRIM ADD DONE" << endl;
+  primitive_test<uint64_t>(count,8,SUB);
+  primitive_test<unsigned __int128>(count,8,SUB);
+  cout << "PRIM SUB DONE" << endl;
+  primitive_test<uint64_t>(count,8,MUL);
+  primitive_test<unsigned __int128>(count,8,MUL);
+  cout << "PRIM MUL DONE" << endl;
+}
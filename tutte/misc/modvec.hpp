@@ -0,0 +1,309 @@
+// (C) Copyright David James Pearce and Gary Haggard, 2007.
+// Permission to copy, use, modify, sell and distribute this software
+// is granted provided this copyright notice appears in all copies.
+// This software is provided "as is" without express or implied
+// warranty, and with no claim as to its suitability for any purpose.
+//
+// Email: david.pearce@mcs.vuw.ac.nz
+
+#ifndef MODVEC_HPP
+#define MODVEC_HPP
+
+#include <iostream>
+#include <vector>
+#include <stdint.h>
+
+#include "bstreambuf.hpp"
+#include "bistream.hpp"
+#include "biguint.hpp"
+
+// The largest number of primes a modvec can use.
+#define MODVEC_MAX_PRIMES 8
+
+// Every prime is greater than 2^MODVEC_PRIME_BITS.  Thus, K primes
+// suffice to reconstruct any value below 2^(K*MODVEC_PRIME_BITS).
+#define MODVEC_PRIME_BITS 61
+
+// The largest primes below 2^62.  Being less than 2^62 means the sum
+// of two residues cannot overflow 64 bits.
+static const uint64_t modvec_primes[MODVEC_MAX_PRIMES] = {
+  0x3fffffffffffffc7ULL, 0x3fffffffffffffa9ULL,
+  0x3fffffffffffff8bULL, 0x3fffffffffffff71ULL,
+  0x3fffffffffffff67ULL, 0x3fffffffffffff59ULL,
+  0x3fffffffffffff55ULL, 0x3fffffffffffff3dULL
+};
+
+// Residues are held in Montgomery form (i.e. aR mod p, where R =
+// 2^64).  This avoids any division when multiplying.  The following
+// give -1/p mod 2^64, R^2 mod p and R mod p for each prime.
+static const uint64_t modvec_ninvs[MODVEC_MAX_PRIMES] = {
+  0xc23ee08fb823ee09ULL, 0xa6fd0eb66fd0eb67ULL,
+  0x0fdcfdcfdcfdcfddULL, 0x2fe35b4cfaa11e6fULL,
+  0x93a8fe53a8fe53a9ULL, 0xcd07aa27db35a717ULL,
+  0xc0bfa02fe80bfa03ULL, 0xefeafeafeafeafebULL
+};
+
+static const uint64_t modvec_r2s[MODVEC_MAX_PRIMES] = {
+  0xcb10ULL, 0x1d910ULL, 0x35790ULL, 0x4fe10ULL,
+  0x5b710ULL, 0x6cf10ULL, 0x72390ULL, 0x94890ULL
+};
+
+static const uint64_t modvec_r1s[MODVEC_MAX_PRIMES] = {
+  0xe4ULL, 0x15cULL, 0x1d4ULL, 0x23cULL,
+  0x264ULL, 0x29cULL, 0x2acULL, 0x30cULL
+};
+
+inline uint64_t modvec_addmod(uint64_t a, uint64_t b, uint64_t p) {
+  uint64_t r = a + b;
+  return r >= p ? r - p : r;
+}
+
+inline uint64_t modvec_submod(uint64_t a, uint64_t b, uint64_t p) {
+  return a >= b ? a - b : (a + p) - b;
+}
+
+// compute the full 128-bit product of a and b
+inline void modvec_mul128(uint64_t a, uint64_t b, uint64_t &hi, uint64_t &lo) {
+#ifdef __SIZEOF_INT128__
+  unsigned __int128 r = (unsigned __int128) a * b;
+  hi = (uint64_t) (r >> 64U);
+  lo = (uint64_t) r;
+#else
+  // no 128-bit type, so build from 32-bit products
+  uint64_t al = a & 0xffffffffU, ah = a >> 32U;
+  uint64_t bl = b & 0xffffffffU, bh = b >> 32U;
+  uint64_t ll = al * bl, lh = al * bh, hl = ah * bl, hh = ah * bh;
+  uint64_t mid = (ll >> 32U) + (lh & 0xffffffffU) + (hl & 0xffffffffU);
+  lo = (mid << 32U) | (ll & 0xffffffffU);
+  hi = hh + (lh >> 32U) + (hl >> 32U) + (mid >> 32U);
+#endif
+}
+
+// Montgomery multiplication of the ith prime: determine ab/R mod p.
+inline uint64_t modvec_mulmod(uint64_t a, uint64_t b, unsigned int i) {
+  uint64_t p = modvec_primes[i];
+  uint64_t hi, lo, mhi, mlo;
+  modvec_mul128(a,b,hi,lo);
+  uint64_t m = lo * modvec_ninvs[i];
+  modvec_mul128(m,p,mhi,mlo);
+  // lo + mlo is zero (mod 2^64), so only the carry matters
+  uint64_t r = hi + mhi + (lo != 0);
+  return r >= p ? r - p : r;
+}
+
+// convert v (where v < p) into Montgomery form for the ith prime
+inline uint64_t modvec_to_mont(uint64_t v, unsigned int i) {
+  return modvec_mulmod(v,modvec_r2s[i],i);
+}
+
+// convert v out of Montgomery form for the ith prime
+inline uint64_t modvec_from_mont(uint64_t v, unsigned int i) {
+  return modvec_mulmod(v,1,i);
+}
+
+// determine v^n (in Montgomery form) for the ith prime
+inline uint64_t modvec_powmod(uint64_t v, uint64_t n, unsigned int i) {
+  uint64_t r = modvec_r1s[i];
+  while(n != 0) {
+    if(n & 1U) { r = modvec_mulmod(r,v,i); }
+    v = modvec_mulmod(v,v,i);
+    n >>= 1U;
+  }
+  return r;
+}
+
+// determine v mod p (in Montgomery form) for the ith prime.
+inline uint64_t modvec_reduce(biguint const &v, unsigned int i) {
+  uint64_t p = modvec_primes[i];
+  if(v <= (uint64_t) 0xffffffffffffffffULL) { return modvec_to_mont(v.c_uint64() % p,i); }
+  // break v into base 2^31 digits, and then reduce using Horner's rule
+  biguint tmp(v);
+  uint32_t base = UINT32_C(1) << 31U;
+  uint64_t mbase = modvec_to_mont(base,i);
+  std::vector<uint32_t> digits;
+  while(tmp != UINT32_C(0)) {
+    digits.push_back(tmp % base);
+    tmp /= base;
+  }
+  uint64_t r = 0;
+  for(unsigned int j=digits.size();j>0;--j) {
+    r = modvec_addmod(modvec_mulmod(r,mbase,i),modvec_to_mont(digits[j-1],i),p);
+  }
+  return r;
+}
+
+/**
+ * A modvec represents a nonnegative integer by its residues modulo
+ * the first K of modvec_primes.  Arithmetic on modvecs is exact
+ * modulo the product of those primes, and involves no heap
+ * allocation.  Thus, a computation whose final values are known to be
+ * below that product can be done entirely with modvecs, and the exact
+ * values then recovered (via the Chinese Remainder Theorem) by
+ * converting to biguint.
+ */
+
+template<unsigned int K>
+class modvec {
+private:
+  uint64_t residues[K];
+public:
+  /* =============================== */
+  /* ========= CONSTRUCTORS ======== */
+  /* =============================== */
+
+  modvec() {
+    for(unsigned int i=0;i!=K;++i) { residues[i] = 0; }
+  }
+
+  modvec(uint32_t v) {
+    for(unsigned int i=0;i!=K;++i) { residues[i] = modvec_to_mont(v,i); }
+  }
+
+  modvec(biguint const &v) {
+    for(unsigned int i=0;i!=K;++i) { residues[i] = modvec_reduce(v,i); }
+  }
+
+  /* =============================== */
+  /* ======== ARITHMETIC OPS ======= */
+  /* =============================== */
+
+  void operator+=(uint32_t v) {
+    for(unsigned int i=0;i!=K;++i) {
+      uint64_t mv = (v == 1) ? modvec_r1s[i] : modvec_to_mont(v,i);
+      residues[i] = modvec_addmod(residues[i],mv,modvec_primes[i]);
+    }
+  }
+
+  void operator+=(modvec<K> const &v) {
+    for(unsigned int i=0;i!=K;++i) {
+      residues[i] = modvec_addmod(residues[i],v.residues[i],modvec_primes[i]);
+    }
+  }
+
+  void operator-=(uint32_t v) {
+    for(unsigned int i=0;i!=K;++i) {
+      uint64_t mv = (v == 1) ? modvec_r1s[i] : modvec_to_mont(v,i);
+      residues[i] = modvec_submod(residues[i],mv,modvec_primes[i]);
+    }
+  }
+
+  void operator-=(modvec<K> const &v) {
+    for(unsigned int i=0;i!=K;++i) {
+      residues[i] = modvec_submod(residues[i],v.residues[i],modvec_primes[i]);
+    }
+  }
+
+  void operator*=(modvec<K> const &v) {
+    for(unsigned int i=0;i!=K;++i) {
+      residues[i] = modvec_mulmod(residues[i],v.residues[i],i);
+    }
+  }
+
+  void operator*=(biguint const &v) {
+    for(unsigned int i=0;i!=K;++i) {
+      residues[i] = modvec_mulmod(residues[i],modvec_reduce(v,i),i);
+    }
+  }
+
+  modvec<K> operator+(modvec<K> const &v) const {
+    modvec<K> r(*this);
+    r += v;
+    return r;
+  }
+
+  modvec<K> operator-(modvec<K> const &v) const {
+    modvec<K> r(*this);
+    r -= v;
+    return r;
+  }
+
+  modvec<K> operator*(modvec<K> const &v) const {
+    modvec<K> r(*this);
+    r *= v;
+    return r;
+  }
+
+  /* =============================== */
+  /* ======== COMPARISON OPS ======= */
+  /* =============================== */
+
+  // the residues are always fully reduced, so this is exact
+  bool operator==(uint32_t v) const {
+    for(unsigned int i=0;i!=K;++i) {
+      if(residues[i] != modvec_to_mont(v,i)) { return false; }
+    }
+    return true;
+  }
+
+  bool operator!=(uint32_t v) const { return !(*this == v); }
+
+  /* =============================== */
+  /* ======== CONVERSION OPS ======= */
+  /* =============================== */
+
+  // Reconstruct the value from its residues using Garner's algorithm.
+  // This gives the unique value below the product of the primes.
+  operator biguint() const {
+    static uint64_t inverses[K][K]; // inverses[j][i] = 1/p_j mod p_i
+    static bool initialised = false;
+    if(!initialised) {
+      for(unsigned int i=0;i!=K;++i) {
+	for(unsigned int j=0;j!=i;++j) {
+	  uint64_t p = modvec_primes[i];
+	  uint64_t pj = modvec_to_mont(modvec_primes[j] % p,i);
+	  inverses[j][i] = modvec_powmod(pj,p-2,i);
+	}
+      }
+      initialised = true;
+    }
+    // first, compute the mixed radix digits
+    uint64_t digits[K];
+    for(unsigned int i=0;i!=K;++i) {
+      uint64_t p = modvec_primes[i];
+      uint64_t d = residues[i];
+      for(unsigned int j=0;j!=i;++j) {
+	uint64_t dj = modvec_to_mont(digits[j] % p,i);
+	d = modvec_mulmod(modvec_submod(d,dj,p),inverses[j][i],i);
+      }
+      digits[i] = modvec_from_mont(d,i);
+    }
+    // second, combine them
+    biguint r(digits[K-1]);
+    for(unsigned int i=K-1;i>0;--i) {
+      r *= biguint(modvec_primes[i-1]);
+      r += biguint(digits[i-1]);
+    }
+    return r;
+  }
+
+  template<unsigned int L>
+  friend bstreambuf &operator<<(bstreambuf &, modvec<L> const &);
+  template<unsigned int L>
+  friend bistream &operator>>(bistream &, modvec<L> &);
+};
+
+template<unsigned int K>
+std::ostream &operator<<(std::ostream &out, modvec<K> const &v) {
+  out << biguint(v);
+  return out;
+}
+
+template<unsigned int K>
+bstreambuf &operator<<(bstreambuf &bout, modvec<K> const &v) {
+  for(unsigned int i=0;i!=K;++i) {
+    bout << (unsigned long long) v.residues[i];
+  }
+  return bout;
+}
+
+template<unsigned int K>
+bistream &operator>>(bistream &bin, modvec<K> &v) {
+  for(unsigned int i=0;i!=K;++i) {
+    unsigned long long r;
+    bin >> r;
+    v.residues[i] = r;
+  }
+  return bin;
+}
+
+#endif
@@ -0,0 +1,249 @@
+#include <iostream>
+#include <cstdlib>
+#include <getopt.h>
+#include <time.h>
+
+#include "modvec.hpp"
+
+using namespace std;
+
+typedef enum { ADD, SUB, MUL } aop;
+
+uint32_t random_word() {
+  uint32_t w1 = (uint32_t) (65536.0*rand()/(RAND_MAX+1.0));
+  uint32_t w2 = (uint32_t) (65536.0*rand()/(RAND_MAX+1.0));
+  return (w1 << 16U) + w2;
+}
+
+uint64_t random_uint64() {
+  return (((uint64_t) random_word()) << 32U) + random_word();
+}
+
+string op2str(aop op) {
+  if(op == ADD) { return "+"; }
+  else if(op == SUB) { return "-"; }
+  else { return "*"; }
+}
+
+// a random value with the given number of (32-bit) words
+biguint random_biguint(uint32_t length) {
+  biguint r(random_word());
+  for(uint32_t j=1;j<length;++j) {
+    r *= UINT32_C(1) << 16U;
+    r *= UINT32_C(1) << 16U;
+    r += random_word();
+  }
+  return r;
+}
+
+// Determine v mod p the long way round (i.e. without modvec_reduce),
+// by working through v in base 2^16 digits.
+uint64_t biguint_mod(biguint v, uint64_t p) {
+  vector<uint32_t> digits;
+  while(v != UINT32_C(0)) {
+    digits.push_back(v % UINT32_C(65536));
+    v /= UINT32_C(65536);
+  }
+  unsigned __int128 r = 0;
+  for(uint32_t j=digits.size();j>0;--j) {
+    r = ((r << 16U) + digits[j-1]) % p;
+  }
+  return (uint64_t) r;
+}
+
+// the product of the first K primes
+biguint prime_product(unsigned int K) {
+  biguint r(UINT32_C(1));
+  for(unsigned int i=0;i!=K;++i) { r *= biguint(modvec_primes[i]); }
+  return r;
+}
+
+// Check the Montgomery arithmetic on single residues against 128-bit
+// arithmetic.
+void montgomery_test(uint32_t count) {
+  for(uint32_t i=0;i!=count;++i) {
+    for(unsigned int j=0;j!=MODVEC_MAX_PRIMES;++j) {
+      uint64_t p = modvec_primes[j];
+      uint64_t a = random_uint64() % p;
+      uint64_t b = random_uint64() % p;
+      uint64_t n = random_word() % 100;
+      uint64_t ma = modvec_to_mont(a,j);
+      uint64_t mb = modvec_to_mont(b,j);
+      uint64_t prod = (uint64_t) (((unsigned __int128) a * b) % p);
+      uint64_t pow = 1;
+      for(uint64_t k=0;k!=n;++k) {
+	pow = (uint64_t) (((unsigned __int128) pow * a) % p);
+      }
+
+      if(modvec_from_mont(ma,j) != a) {
+	cout << "ERROR(1): " << a << " mod p" << j << " read back as " << modvec_from_mont(ma,j) << endl;
+      } else if(modvec_from_mont(modvec_mulmod(ma,mb,j),j) != prod) {
+	cout << "ERROR(2): " << a << " * " << b << " mod p" << j << " gives " << modvec_from_mont(modvec_mulmod(ma,mb,j),j) << ", not " << prod << endl;
+      } else if(modvec_from_mont(modvec_addmod(ma,mb,p),j) != (uint64_t) (((unsigned __int128) a + b) % p)) {
+	cout << "ERROR(3): " << a << " + " << b << " mod p" << j << " failed" << endl;
+      } else if(modvec_from_mont(modvec_submod(ma,mb,p),j) != (a >= b ? a - b : (p - b) + a)) {
+	cout << "ERROR(4): " << a << " - " << b << " mod p" << j << " failed" << endl;
+      } else if(modvec_from_mont(modvec_powmod(ma,n,j),j) != pow) {
+	cout << "ERROR(5): " << a << " ^ " << n << " mod p" << j << " gives " << modvec_from_mont(modvec_powmod(ma,n,j),j) << ", not " << pow << endl;
+      }
+    }
+  }
+}
+
+// Check sums and products of random (multi-word) values.  The result
+// is reconstructed, which must then be below the product of the
+// primes and agree with the biguint result modulo each prime.
+template<unsigned int K>
+void primitive_test(uint32_t count, uint32_t length, aop op) {
+  biguint P(prime_product(K));
+  biguint Q(P); // a multiple of P which exceeds any random value
+  for(uint32_t j=0;j!=length;++j) {
+    Q *= UINT32_C(1) << 16U;
+    Q *= UINT32_C(1) << 16U;
+  }
+  for(uint32_t i=0;i!=count;++i) {
+    biguint a(random_biguint(1+(rand() % length)));
+    biguint b(random_biguint(1+(rand() % length)));
+    uint32_t w(random_word());
+    modvec<K> m1(a);
+    modvec<K> m2(a);
+    biguint r(a);
+
+    if(op == ADD) {
+      m1 += modvec<K>(b);
+      m2 += w;
+      r += b;
+    } else if(op == SUB) {
+      // add Q first, so that the biguint result cannot go negative
+      r += Q;
+      m1 -= modvec<K>(b);
+      m2 -= w;
+      r -= b;
+    } else if(op == MUL) {
+      m1 *= modvec<K>(b);
+      m2 *= b;
+      r *= b;
+    }
+
+    biguint v1(m1), v2(m2);
+    if(v1 >= P || v2 >= P) {
+      cout << "ERROR(1): " << a << " " << op2str(op) << " " << b << " gives " << v1 << " or " << v2 << ", which is not below " << P << endl;
+      continue;
+    }
+    biguint r2(op == ADD ? a + w : (op == SUB ? r + b - w : r));
+    for(unsigned int j=0;j!=K;++j) {
+      uint64_t p = modvec_primes[j];
+      if(biguint_mod(v1,p) != biguint_mod(r,p)) {
+	cout << "ERROR(2): " << a << " " << op2str(op) << " " << b << " gives " << v1 << ", which differs from " << r << " mod p" << j << endl;
+      } else if(biguint_mod(v2,p) != biguint_mod(r2,p)) {
+	cout << "ERROR(3): " << a << " " << op2str(op) << " " << (op == MUL ? b : biguint(w)) << " gives " << v2 << ", which differs from " << r2 << " mod p" << j << endl;
+      }
+    }
+  }
+}
+
+// Check that values right up to just below the product of the primes
+// survive the round trip through their residues.
+template<unsigned int K>
+void crt_test(uint32_t count) {
+  biguint P(prime_product(K));
+  biguint Pm1(P - UINT32_C(1));
+  biguint top(UINT32_C(1)); // 2^(K*MODVEC_PRIME_BITS) - 1
+  for(unsigned int k=0;k!=K*MODVEC_PRIME_BITS;++k) { top *= UINT32_C(2); }
+  top -= UINT32_C(1);
+
+  vector<biguint> values;
+  values.push_back(biguint(UINT32_C(0)));
+  values.push_back(biguint(UINT32_C(1)));
+  values.push_back(Pm1);
+  values.push_back(top);
+  for(unsigned int j=0;j!=K;++j) {
+    values.push_back(biguint(modvec_primes[j] - 1));
+    if(j+1 < K) { values.push_back(biguint(modvec_primes[j])); }
+  }
+  for(uint32_t i=0;i!=count;++i) {
+    // (K words are well below P, since each prime is above 2^61)
+    values.push_back(Pm1 - random_biguint(1+(rand() % K)));
+    biguint v(random_biguint(1+(rand() % (2*K))));
+    while(v >= P) { v /= UINT32_C(2); }
+    values.push_back(v);
+  }
+
+  for(uint32_t i=0;i!=values.size();++i) {
+    biguint v(values[i]);
+    modvec<K> m(v);
+    biguint r(m);
+    if(r != v) {
+      cout << "ERROR(1): " << v << " (K = " << K << ") read back as " << r << endl;
+    }
+  }
+
+  // zero minus one wraps round to P-1
+  modvec<K> z(UINT32_C(0));
+  z -= UINT32_C(1);
+  if(biguint(z) != Pm1) {
+    cout << "ERROR(2): 0 - 1 (K = " << K << ") gives " << biguint(z) << ", not " << Pm1 << endl;
+  }
+}
+
+int main(int argc, char *argv[]) {
+
+  // ------------------------------
+  // Process command-line arguments
+  // ------------------------------
+
+  #define OPT_HELP 0
+  #define OPT_COUNT 1
+
+  struct option long_options[]={
+    {"help",no_argument,NULL,OPT_HELP},
+    {"count",required_argument,NULL,OPT_COUNT},
+    NULL
+  };
+
+  char *descriptions[]={
+    "        --help                    display this information",
+    " -c     --count=<amount>          number of times to repeat each test",
+    NULL
+  };
+
+  uint32_t count = 10000;
+  uint32_t v;
+
+  while((v=getopt_long(argc,argv,"c:",long_options,NULL)) != -1) {
+    switch(v) {
+    case OPT_HELP:
+      cout << "usage: " << argv[0] << " [options]" << endl;
+      cout << "options:" << endl;
+      for(char **ptr=descriptions;*ptr != NULL; ptr++) {
+	cout << *ptr << endl;
+      }
+      exit(1);
+
+    case 'c':
+    case OPT_COUNT:
+      count = atoi(optarg);
+    }
+  }
+
+  // seed random number generator
+  srand(time(NULL));
+  // do the tests!
+  montgomery_test(count);
+  cout << "MONTGOMERY DONE" << endl;
+  primitive_test<1>(count,2,ADD);
+  primitive_test<4>(count,8,ADD);
+  cout << "PRIM ADD DONE" << endl;
+  primitive_test<1>(count,2,SUB);
+  primitive_test<4>(count,8,SUB);
+  cout << "PRIM SUB DONE" << endl;
+  primitive_test<1>(count,2,MUL);
+  primitive_test<4>(count,4,MUL);
+  primitive_test<8>(count,8,MUL);
+  cout << "PRIM MUL DONE" << endl;
+  crt_test<1>(count);
+  crt_test<2>(count);
+  crt_test<4>(count);
+  crt_test<8>(count);
+  cout << "CRT DONE" << endl;
+}
@@ -0,0 +1,141 @@
+// (C) Copyright David James Pearce and Gary Haggard, 2007.
+// Permission to copy, use, modify, sell and distribute this software
+// is granted provided this copyright notice appears in all copies.
+// This software is provided "as is" without express or implied
+// warranty, and with no claim as to its suitability for any purpose.
+//
+// Email: david.pearce@mcs.vuw.ac.nz
+
+#ifndef DENSE_MUL_HPP
+#define DENSE_MUL_HPP
+
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+
+/**
+ * Multiplication of dense univariate polynomials, given as arrays of
+ * coefficients (lowest power first).  Karatsuba's method is used
+ * above a threshold, and schoolbook multiplication below it.  Only
+ * addition, subtraction and multiplication of coefficients are
+ * needed, so this works for any of the coefficient types.  (When the
+ * coefficients are unsigned, no intermediate value goes negative,
+ * since all inputs are nonnegative.)
+ */
+
+// Below these lengths, schoolbook multiplication is faster (as
+// measured by poly/mul_bench.cpp).  The cheaper a coefficient product
+// is, the longer the polynomials must be before Karatsuba pays off.
+#ifndef DENSE_KARATSUBA_THRESHOLD
+#define DENSE_KARATSUBA_THRESHOLD 16
+#endif
+#ifndef DENSE_KARATSUBA_THRESHOLD_MODVEC
+#define DENSE_KARATSUBA_THRESHOLD_MODVEC 32
+#endif
+#ifndef DENSE_KARATSUBA_THRESHOLD_FIXED
+#define DENSE_KARATSUBA_THRESHOLD_FIXED 48
+#endif
+
+template<class W> class fixed_uint;
+template<unsigned int K> class modvec;
+
+template<class T>
+struct dense_karatsuba_threshold {
+  static const unsigned int value = DENSE_KARATSUBA_THRESHOLD;
+};
+
+template<class W>
+struct dense_karatsuba_threshold<fixed_uint<W> > {
+  static const unsigned int value = DENSE_KARATSUBA_THRESHOLD_FIXED;
+};
+
+template<unsigned int K>
+struct dense_karatsuba_threshold<modvec<K> > {
+  static const unsigned int value = DENSE_KARATSUBA_THRESHOLD_MODVEC;
+};
+
+// r[i+j] += a[i] * b[j]
+template<class T>
+void dense_mul_schoolbook(T *r, T const *a, unsigned int na, T const *b, unsigned int nb) {
+  for(unsigned int j=0;j<nb;++j) {
+    T const &v(b[j]);
+    T *rs = r + j;
+    for(unsigned int i=0;i<na;++i) {
+      rs[i] += a[i] * v;
+    }
+  }
+}
+
+// r[0..2n-1) = a * b, where a and b both have n coefficients.  The
+// workspace needs room for 4n coefficients.
+template<class T>
+void dense_mul_karatsuba(T *r, T const *a, T const *b, unsigned int n, T *ws) {
+  if(n < dense_karatsuba_threshold<T>::value) {
+    for(unsigned int i=0;i<(2*n)-1;++i) { r[i] = UINT32_C(0); }
+    dense_mul_schoolbook(r,a,n,b,n);
+    return;
+  }
+  // split into a = a0 + a1*z^m, and b = b0 + b1*z^m
+  unsigned int m = n / 2;
+  unsigned int h = n - m;
+  T const *a0 = a, *a1 = a + m;
+  T const *b0 = b, *b1 = b + m;
+  // r = a0*b0 + a1*b1*z^2m (these don't overlap)
+  dense_mul_karatsuba(r,a0,b0,m,ws);
+  r[(2*m)-1] = UINT32_C(0);
+  dense_mul_karatsuba(r+(2*m),a1,b1,h,ws);
+  // z = (a0+a1)*(b0+b1) - a0*b0 - a1*b1
+  T *sa = ws;
+  T *sb = ws + h;
+  T *z = ws + (2*h);
+  for(unsigned int i=0;i<h;++i) {
+    sa[i] = a1[i];
+    sb[i] = b1[i];
+    if(i < m) {
+      sa[i] += a0[i];
+      sb[i] += b0[i];
+    }
+  }
+  // the recursive call needs its own workspace, which comes after z
+  dense_mul_karatsuba(z,sa,sb,h,ws + (4*h));
+  for(unsigned int i=0;i<(2*m)-1;++i) { z[i] -= r[i]; }
+  for(unsigned int i=0;i<(2*h)-1;++i) { z[i] -= r[(2*m)+i]; }
+  // finally, r += z*z^m
+  for(unsigned int i=0;i<(2*h)-1;++i) { r[m+i] += z[i]; }
+}
+
+// the workspace needed by dense_mul_karatsuba for n coefficients
+template<class T>
+unsigned int dense_mul_workspace(unsigned int n) {
+  unsigned int r = 0;
+  while(n >= dense_karatsuba_threshold<T>::value) {
+    unsigned int h = n - (n / 2);
+    r += 4*h;
+    n = h;
+  }
+  return r + 1;
+}
+
+// r[0..na+nb-1) += a * b
+template<class T>
+void dense_mul(T *r, T const *a, unsigned int na, T const *b, unsigned int nb) {
+  if(na < nb) { std::swap(a,b); std::swap(na,nb); }
+  if(nb < dense_karatsuba_threshold<T>::value) {
+    dense_mul_schoolbook(r,a,na,b,nb);
+    return;
+  }
+  // Split a into pieces of length nb, so that each product is
+  // balanced.  The last piece is padded with zeros.
+  std::vector<T> ws(dense_mul_workspace<T>(nb) + (3*nb),T(UINT32_C(0)));
+  T *piece = &ws[0];
+  T *prod = piece + nb;
+  T *kws = prod + (2*nb);
+  for(unsigned int i=0;i<na;i+=nb) {
+    unsigned int len = std::min(nb,na-i);
+    for(unsigned int j=0;j<nb;++j) { piece[j] = (j < len) ? a[i+j] : T(UINT32_C(0)); }
+    dense_mul_karatsuba(prod,piece,b,nb,kws);
+    for(unsigned int j=0;j<(len+nb)-1;++j) { r[i+j] += prod[j]; }
+  }
+}
+
+#endif
@@ -0,0 +1,241 @@
+// (C) Copyright David James Pearce and Gary Haggard, 2007.
+// Permission to copy, use, modify, sell and distribute this software
+// is granted provided this copyright notice appears in all copies.
+// This software is provided "as is" without express or implied
+// warranty, and with no claim as to its suitability for any purpose.
+//
+// Email: david.pearce@mcs.vuw.ac.nz
+
+#ifndef EVAL_POLY_HPP
+#define EVAL_POLY_HPP
+
+#include <string>
+#include <sstream>
+#include <vector>
+#include <utility>
+#include <stdexcept>
+
+#include "xy_term.hpp"
+#include "../misc/bistream.hpp"
+#include "../misc/bstreambuf.hpp"
+#include "../misc/biguint.hpp"
+#include "../misc/bigint.hpp"
+
+/**
+ * An eval_poly stands in for a polynomial when only its value at a
+ * fixed set of points is required.  Rather than storing coefficients,
+ * it stores the value of the polynomial at each point.  Thus, each
+ * arithmetic operation costs O(1) per point, and cache entries hold
+ * just one value per point.
+ *
+ * The points must be set (via set_points) before any eval_poly is
+ * constructed.
+ */
+
+template<class T = bigint>
+class eval_poly {
+private:
+  std::vector<T> values;
+
+  // the evaluation points, along with tables of powers for each
+  static std::vector<std::pair<int,int> > points;
+  static std::vector<std::vector<T> > xpowers;
+  static std::vector<std::vector<T> > ysums; // ysums[p][k] = y^0 + ... + y^(k-1)
+
+  template<class S>
+  friend bstreambuf &operator<<(bstreambuf &,eval_poly<S> const &);
+  template<class S>
+  friend bistream &operator>>(bistream &,eval_poly<S> &);
+public:
+  /* =============================== */
+  /* ========= CONSTRUCTORS ======== */
+  /* =============================== */
+
+  eval_poly() : values(points.size(),T(INT32_C(0))) {}
+
+  eval_poly(xy_term const &xyt) {
+    values.reserve(points.size());
+    for(unsigned int i=0;i!=points.size();++i) {
+      values.push_back(term_value(i,xyt));
+    }
+  }
+
+  void swap(eval_poly<T> &src) BUI_NOEXCEPT {
+    values.swap(src.values);
+  }
+
+  /* =============================== */
+  /* ======== ARITHMETIC OPS ======= */
+  /* =============================== */
+
+  void operator+=(xy_term const &p) {
+    for(unsigned int i=0;i!=values.size();++i) { values[i] += term_value(i,p); }
+  }
+
+  void operator+=(eval_poly const &p) {
+    for(unsigned int i=0;i!=values.size();++i) { values[i] += p.values[i]; }
+  }
+
+  void operator-=(xy_term const &p) {
+    for(unsigned int i=0;i!=values.size();++i) { values[i] -= term_value(i,p); }
+  }
+
+  void operator-=(eval_poly const &p) {
+    for(unsigned int i=0;i!=values.size();++i) { values[i] -= p.values[i]; }
+  }
+
+  void operator*=(biguint coefficient) {
+    for(unsigned int i=0;i!=values.size();++i) { values[i] *= coefficient; }
+  }
+
+  void operator*=(xy_term const &p) {
+    for(unsigned int i=0;i!=values.size();++i) { values[i] *= term_value(i,p); }
+  }
+
+  void operator*=(eval_poly<T> const &p) {
+    for(unsigned int i=0;i!=values.size();++i) { values[i] *= p.values[i]; }
+  }
+
+  // this += a * b
+  void add_product(eval_poly<T> const &a, eval_poly<T> const &b) {
+    for(unsigned int i=0;i!=values.size();++i) { values[i] += a.values[i] * b.values[i]; }
+  }
+
+  // this += a * t
+  void add_shifted(eval_poly<T> const &a, xy_term const &t) {
+    for(unsigned int i=0;i!=values.size();++i) { values[i] += a.values[i] * term_value(i,t); }
+  }
+
+  // Set this to (this - n) / (xy - x - y), which must divide exactly
+  // (see factor_poly::divide_2sum).  This is only possible when the
+  // divisor is nonzero at every point, i.e. not at (0,0) or (2,2).
+  void divide_2sum(eval_poly<T> const &n) {
+    for(unsigned int i=0;i!=values.size();++i) {
+      int32_t x = points[i].first, y = points[i].second;
+      int32_t d = (x*y) - x - y;
+      if(d == 0) {
+	std::ostringstream out;
+	out << "cannot divide by xy - x - y at (" << x << "," << y << ")";
+	throw std::runtime_error(out.str());
+      }
+      values[i] -= n.values[i];
+      values[i] /= d;
+    }
+  }
+
+  eval_poly<T> operator+(eval_poly<T> const &p) const {
+    eval_poly<T> r(*this);
+    r += p;
+    return r;
+  }
+
+  eval_poly<T> operator-(eval_poly<T> const &p) const {
+    eval_poly<T> r(*this);
+    r -= p;
+    return r;
+  }
+
+  eval_poly<T> operator*(xy_term const &p) const {
+    eval_poly<T> r(*this);
+    r *= p;
+    return r;
+  }
+
+  eval_poly<T> operator*(eval_poly<T> const &p) const {
+    eval_poly<T> r(*this);
+    r *= p;
+    return r;
+  }
+
+  /* ========================== */
+  /* ======== OTHER OPS ======= */
+  /* ========================== */
+
+  std::string str() const {
+    std::stringstream ss;
+    for(unsigned int i=0;i!=values.size();++i) {
+      if(i != 0) { ss << ", "; }
+      ss << "(" << points[i].first << "," << points[i].second << ") = " << values[i];
+    }
+    return ss.str();
+  }
+
+  T substitute(int32_t x, int32_t y) const {
+    for(unsigned int i=0;i!=points.size();++i) {
+      if(points[i].first == x && points[i].second == y) { return values[i]; }
+    }
+    std::ostringstream out;
+    out << "point (" << x << "," << y << ") was not evaluated";
+    throw std::runtime_error(out.str());
+  }
+
+  std::vector<T> substitute(std::vector<std::pair<int,int> > const &ps) const {
+    std::vector<T> r;
+    r.reserve(ps.size());
+    for(unsigned int i=0;i!=ps.size();++i) {
+      r.push_back(substitute(ps[i].first,ps[i].second));
+    }
+    return r;
+  }
+
+  static void set_points(std::vector<std::pair<int,int> > const &ps) {
+    points = ps;
+    xpowers = std::vector<std::vector<T> >(ps.size(),std::vector<T>(1,T(INT32_C(1))));
+    ysums = std::vector<std::vector<T> >(ps.size(),std::vector<T>(1,T(INT32_C(0))));
+  }
+
+private:
+  // determine value of x^a * (y^b + ... + y^c) at the ith point
+  static T term_value(unsigned int i, xy_term const &t) {
+    T r = ysum(i,t.ypowerend+1);
+    r -= ysum(i,t.ypower);
+    r *= xpower(i,t.xpower);
+    return r;
+  }
+
+  static T const &xpower(unsigned int i, unsigned int n) {
+    std::vector<T> &xs(xpowers[i]);
+    while(xs.size() <= n) {
+      xs.push_back(xs.back() * T(points[i].first));
+    }
+    return xs[n];
+  }
+
+  static T const &ysum(unsigned int i, unsigned int n) {
+    std::vector<T> &ys(ysums[i]);
+    if(ys.size() <= n) {
+      // ysums[i][k] - ysums[i][k-1] = y^(k-1)
+      T ypow = T(points[i].second) ^ (ys.size()-1);
+      while(ys.size() <= n) {
+	ys.push_back(ys.back() + ypow);
+	ypow *= T(points[i].second);
+      }
+    }
+    return ys[n];
+  }
+};
+
+template<class T>
+std::vector<std::pair<int,int> > eval_poly<T>::points;
+template<class T>
+std::vector<std::vector<T> > eval_poly<T>::xpowers;
+template<class T>
+std::vector<std::vector<T> > eval_poly<T>::ysums;
+
+template<class T>
+bstreambuf &operator<<(bstreambuf &bout, eval_poly<T> const &ep) {
+  for(unsigned int i=0;i!=ep.values.size();++i) {
+    bout << ep.values[i];
+  }
+  return bout;
+}
+
+template<class T>
+bistream &operator>>(bistream &bin, eval_poly<T> &ep) {
+  for(unsigned int i=0;i!=ep.values.size();++i) {
+    bin >> ep.values[i];
+  }
+  return bin;
+}
+
+#endif
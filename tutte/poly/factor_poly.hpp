@@ -1,7 +1,7 @@
-// (C) Copyright David James Pearce and Gary Haggard, 2007. 
-// Permission to copy, use, modify, sell and distribute this software 
-// is granted provided this copyright notice appears in all copies. 
-// This software is provided "as is" without express or implied 
+// (C) Copyright David James Pearce and Gary Haggard, 2007.
+// Permission to copy, use, modify, sell and distribute this software
+// is granted provided this copyright notice appears in all copies.
+// This software is provided "as is" without express or implied
 // warranty, and with no claim as to its suitability for any purpose.
 //
 // Email: david.pearce@mcs.vuw.ac.nz
@@ -11,407 +11,141 @@
 
 #include <iostream>
 #include <string>
+#include <sstream>
 #include <utility>
+#include <new>
+#include <vector>
+#include <algorithm>
+#include <climits>
 
 #include "xy_term.hpp"
+#include "yterms_kernels.hpp"
+#include "dense_mul.hpp"
 #include "../misc/bistream.hpp"
 #include "../misc/bstreambuf.hpp"
 #include "../misc/biguint.hpp"
 #include "../misc/bigint.hpp"
+#include "../misc/fixed_uint.hpp"
+#include "../misc/modvec.hpp"
 
 #define FPOLY_PADDING_FACTOR 1
 
-template<class T>
-class yterms {
-public:  
-  unsigned int ymin;
-  unsigned int ymax;
-
-  template<class S> 
-  friend bstreambuf &operator<<(bstreambuf &, yterms<S> const &);
-  template<class S> 
-  friend bistream &operator>>(bistream &, yterms<S> &);
-private:  
-  unsigned int fpadding;
-  unsigned int bpadding;
-  T *coefficients;
-public:
-  /* =============================== */
-  /* ========= CONSTRUCTORS ======== */
-  /* =============================== */
-
-  yterms() : ymin(1), ymax(0), fpadding(0), bpadding(0), coefficients(NULL) {}
+// the smallest coefficient block worth allocating
+#define FPOLY_MIN_BLOCK 16
 
-  yterms(unsigned int y_min, unsigned int y_max) {    
-    alloc(y_min,y_max);
-  }
-
-  yterms(yterms<T> const &src)  { clone(src); }
-
-  ~yterms() { delete [] coefficients; }
+// the coefficient block starts on a multiple of this
+#define FPOLY_ALIGN 16
 
-  /* =============================== */
-  /* ======== ASSIGNMENT OP ======== */
-  /* =============================== */
-
-  yterms const &operator=(yterms<T> const &src) {
-    if(&src != this) {
-      // now, we try to reuse memory where possible.
-      unsigned int src_ncoeffs = src.size();
-      unsigned int space = size() + fpadding + bpadding;
-      if(space < src_ncoeffs) {
-	delete [] coefficients;
-	clone(src);
-      } else {
-	ymin = src.ymin;
-	ymax = src.ymax;
-	fpadding = 0;
-	bpadding = space - src_ncoeffs;	
-	// copy old stuff over
-	for(unsigned int i=0;i<src_ncoeffs;++i) { 
-	  coefficients[i] = src.coefficients[i];
-	}
-	// clear any old coefficients
-	for(unsigned int i=src_ncoeffs;i<space;++i) {
-	  coefficients[i] = UINT32_C(0);
-	}
-      }
-	
-    }
-    return *this;
-  }
-
-  inline void swap(yterms<T> &src) {
-    std::swap(ymin,src.ymin);
-    std::swap(ymax,src.ymax);
-    std::swap(fpadding,src.fpadding);
-    std::swap(bpadding,src.bpadding);
-    std::swap(coefficients,src.coefficients);
-  }
-
-  /* =============================== */
-  /* ======== ARITHMETIC OPS ======= */
-  /* =============================== */
-
-  void operator+=(xy_term const &p) {
-    // make sure enough y terms
-    resize(p.ypower,p.ypowerend);
-    // now, do the addition
-    for(unsigned int i=p.ypower;i<=p.ypowerend;++i) { 
-      (*this)[i] += 1;
-    }    
-  }
+// Products where both operands have at least this many terms, and
+// whose dense (Kronecker) forms are at most FPOLY_KRONECKER_SPARSITY
+// times that size, are done by Kronecker substitution (see
+// poly/mul_bench.cpp for how these were chosen).
+#define FPOLY_KRONECKER_THRESHOLD 512
+#define FPOLY_KRONECKER_SPARSITY 2
 
-  void operator+=(yterms<T> const &ys) {
-    // make sure enough y terms
-    resize(ys.ymin,ys.ymax);
-    // now, do the addition
-    unsigned int start = ys.ymin;
-    unsigned int end = ys.ymax;
-    for(unsigned int i=start;i<=end;++i) { 
-      (*this)[i] += ys[i];
-    }
-  }
-
-  void operator-=(xy_term const &ys) {
-    // make sure enough y terms
-    resize(ys.ypower,ys.ypowerend);
-    // now, do the subtraction
-    for(unsigned int i=ys.ypower;i<=ys.ypowerend;++i) { 
-      (*this)[i] -= 1;
-    }    
-    // At this stage, we might have reduce the ytems to all zeros and
-    // we could eliminate them ...  
-  }
-
-  void operator-=(yterms<T> const &ys) {
-    // make sure enough y terms
-    resize(ys.ymin,ys.ymax);
-    // now, do the subtraction
-    unsigned int start = ys.ymin;
-    unsigned int end = ys.ymax;
-    for(unsigned int i=start;i<=end;++i) { 
-      (*this)[i] -= ys[i];
-    }
-    // At this stage, we might have reduce the ytems to all zeros and
-    // we could eliminate them ...    
-  }
-
-  void operator*=(biguint coefficient) {
-    int len = (ymax - ymin) + 1;
-    for(unsigned int i=0;i!=len;++i) {
-      coefficients[i+fpadding] *= coefficient;
-    }
-  }
-
-  void operator*=(xy_term const &p) {
-    // if this poly is empty do nothing!
-    if(is_empty()) { return;}
-    // Ok, it's not empty ...
-    unsigned int ystart = ymin;
-    unsigned int yend = ymax;
-    unsigned int ypadding = fpadding;
-    unsigned int nystart = ymin + p.ypower;
-    unsigned int nyend = ymax + p.ypowerend;
-    
-    if(p.ypower == p.ypowerend) {
-      // easy case, only a shift required
-      ymin = nystart;
-      ymax = nyend;
-    } else {
-      // harder case
-      
-      // The following could use padding, since it currently doesn't!
-      T *o_coefficients = coefficients;
-      alloc(nystart,nyend);     
-      unsigned int depth = (p.ypowerend-p.ypower)+1;
-      unsigned int width = (yend-ystart)+1;
-      
-      // going up the triangle
-      T acc = UINT32_C(0);    
-      for(unsigned int i=0;i<std::min(width,depth);++i) {
-	acc += o_coefficients[i+ypadding];
-	coefficients[i+nystart+fpadding-ymin] = acc;
-      }
-      // free fall (if there is any)
-      for(unsigned int i=width;i<depth;++i) {
-	coefficients[i+nystart+fpadding-ymin] = acc;
-      }    
-      // going along the top (if there is one)
-      T sub = UINT32_C(0);
-      for(unsigned int i=depth;i<width;++i) {
-	sub += o_coefficients[i+ypadding-depth];
-	acc += o_coefficients[i+ypadding];
-	coefficients[i+fpadding] = acc - sub;
-      }    
-      // going down the triangle
-      for(unsigned int i=std::max(depth,width);i < (nyend-nystart)+1;++i) {
-	sub += o_coefficients[i+ypadding - depth];
-	coefficients[i+fpadding] = acc - sub;
-      }
-      delete [] o_coefficients;
-    }
-    // and we're done!
-  }
-
-  /* The more complicated general case.
-   * Big question as to whether this code can 
-   * be optimised any more.
-   */
-  void operator*=(yterms<T> const &p) {
-    // if this poly is empty do nothing
-    if(is_empty()) { return; }
-
-    if(p.size() == 1) {
-      // optimise simple case!
-      ymin += p.ymin;
-      ymax += p.ymax;
-      T const &v(p[p.ymin]);
-
-      for(unsigned int i=ymin;i<=ymax;++i) {
-	(*this)[i] *= v;
-      }
-    } else {    
-      yterms<T> r(p.ymin + ymin,p.ymax + ymax);
-      
-      for(unsigned int i=p.ymin;i<=p.ymax;++i) {
-	T const &v(p[i]);
-	for(unsigned int j=ymin;j<=ymax;++j) {
-	  r[j+i] += (*this)[j] * v;
-	}
-      }
-      
-      swap(r); // normal swap trick optimisation
-    }
-  }
-  
-  /* ========================== */
-  /* ======== OTHER FNS ======= */
-  /* ========================== */  
-
-  inline unsigned int size() const {
-    if(coefficients == NULL) { return 0; }
-    return (ymax - ymin) + 1;
-  }
-
-  inline bool is_empty() const { return coefficients == NULL; }
-
-  inline T const &operator[](int i) const { return coefficients[(i + fpadding) - ymin]; }
-  inline T &operator[](int i) { return coefficients[(i + fpadding) - ymin]; }
-
-  bigint substitute(int32_t y) const {
-    if(coefficients != NULL) {
-      bigint r(INT32_C(0));
-      bigint p(y); 
-      for(unsigned int i=ymin;i<=ymax;++i) {	
-	r += (*this)[i] * pow(p,i);
-      }
-      return r;
-    } else {
-      return bigint(INT32_C(0));
-    }
-  }
+/**
+ * Coefficient types which hold no pointers, and so can be copied into
+ * (and out of) the cache as raw bytes.
+ */
+template<class T>
+struct fpoly_flat { static const bool value = false; };
 
-  std::string str() const {
-    std::stringstream ss;
-    if(coefficients == NULL) { 
-      return "";
-    } else if(ymin != ymax) {
-      ss << "y^{" << ymin << ".." << ymax << "}";
-    } else if(ymin == 1) {
-      ss << "y";
-    } else if(ymin != 0) {
-      ss << "y^" << ymin;
-    } 
-    ss << "(";
-    for(unsigned int i=ymin;i<=ymax;++i) {
-      if(i != ymin) { ss << " + "; }
-      ss << (*this)[i];
-    }
-    ss << ")";
-    return ss.str();
-  }
+template<class W>
+struct fpoly_flat<fixed_uint<W> > { static const bool value = true; };
 
-  void insert(unsigned int n, xy_term const &p) {   // needs a better name? 
-    // make sure enough y terms
-    resize(p.ypower,p.ypowerend);
-    // now, do the addition
-    for(unsigned int i=p.ypower;i<=p.ypowerend;++i) { 
-      (*this)[i] += n;
-    }    
-  }
-  
-private:  
-  /* =============================== */
-  /* ======== HELPERS ======= */
-  /* =============================== */
+template<unsigned int K>
+struct fpoly_flat<modvec<K> > { static const bool value = true; };
 
-  void resize(unsigned int n_ymin, unsigned int n_ymax)  {
-    if(is_empty()) {
-      alloc(n_ymin,n_ymax);
-    } else {
-      int d_end = n_ymax - ymax;
-      int d_beg = ymin - n_ymin;
-      
-      if(d_beg <= (int) fpadding && d_end <= (int) bpadding) {
-	// in this case, there is enough padding to cover it
-	if(d_end > 0) {
-	  ymax = n_ymax;      
-	  bpadding -= d_end;
-	}
-	if(d_beg > 0) {
-	  ymin = n_ymin;      
-	  fpadding -= d_beg;
-	}
-      } else {
-	// no, there definitely aren't enough y-terms
-	unsigned int o_ymin = ymin;
-	unsigned int o_ymax = ymax;
-	unsigned int o_fpadding = fpadding;
-	T *o_coefficients = coefficients;	
-	alloc(std::min(o_ymin,n_ymin),std::max(o_ymax,n_ymax));
-	// copy old stuff over
-	for(unsigned int i=o_ymin;i<=o_ymax;++i) { 
-	  (*this)[i] = o_coefficients[(i+o_fpadding)-o_ymin];
-	}
-	// free space!
-	delete [] o_coefficients;
-      }
-    }
-  }  
+// the number of buffers allocated by factor_polys (for the statistics)
+inline unsigned long &fpoly_allocations() {
+  static unsigned long n = 0;
+  return n;
+}
 
-  void clone(yterms<T> const &src) { 
-    if(src.is_empty()) { 
-      coefficients = NULL; ymin = 1; ymax=0; fpadding = 0; bpadding = 0;}
-    else {
-      ymin = src.ymin;
-      ymax = src.ymax;
-      fpadding = src.fpadding;
-      bpadding = src.bpadding;
+// exchange two coefficients without copying them
+template<class T>
+inline void fpoly_swap(T &a, T &b) BUI_NOEXCEPT { std::swap(a,b); }
 
-      unsigned int ncoeffs = src.size() + src.fpadding + src.bpadding;
-      
-      coefficients = new T[ncoeffs];
+inline void fpoly_swap(biguint &a, biguint &b) BUI_NOEXCEPT { a.swap(b); }
 
-      // copy old stuff over
-      for(unsigned int i=0;i<ncoeffs;++i) { 
-	coefficients[i] = src.coefficients[i];
-      }
-    }
-  }
+/**
+ * The coefficients for each power of x (i.e. y^ymin ... y^ymax) are
+ * held in a slot of the coefficient block.  The slot may have spare
+ * room before and after them, so that the row can grow in place.  A
+ * row with ymin > ymax is empty, and has no slot.
+ */
+struct fpoly_row {
+  unsigned int ymin;
+  unsigned int ymax;
+  unsigned int offset;   // position of y^ymin in the coefficient block
+  unsigned int fpadding; // spare room before y^ymin
+  unsigned int bpadding; // spare room after y^ymax
 
-  void alloc(unsigned int _ymin, unsigned int _ymax) {
-    unsigned int nyterms = (_ymax-_ymin)+1;    
-    bpadding = nyterms * FPOLY_PADDING_FACTOR;
-    fpadding = std::min(_ymin,nyterms * FPOLY_PADDING_FACTOR);
-    ymin = _ymin;
-    ymax = _ymax;
-    coefficients = new T[nyterms + bpadding + fpadding];
-    // why the following line is needed is just plain
-    // wierd.
-    for(unsigned int i=0;i<nyterms+fpadding+bpadding;++i) {
-      coefficients[i] = UINT32_C(0);
-    }
-  }
+  inline bool is_empty() const { return ymin > ymax; }
+  inline unsigned int size() const { return is_empty() ? 0 : (ymax - ymin) + 1; }
+  inline unsigned int slot() const { return fpadding + size() + bpadding; }
 };
 
-template<class T> 
-bstreambuf &operator<<(bstreambuf &bout, yterms<T> const &yt) {
-  bout << yt.ymin << yt.ymax;
-
-  for(unsigned int i=yt.ymin;i<=yt.ymax;++i) { bout << yt[i]; }
-}
-
-template<class T> 
-bistream &operator>>(bistream &bin, yterms<T> &yt) {
-  unsigned int ymin, ymax;
-  bin >> ymin >> ymax;
-  if(ymin > ymax) { 
-    yt = yterms<T>(); 
-  } else {
-    yterms<T> tmp(ymin,ymax);
-    for(unsigned int i=tmp.ymin;i<=tmp.ymax;++i) {
-      bin >> tmp[i];
-    }
-    // again, the following trick saves on 
-    // assignment
-    yt.swap(tmp);
-  }
-}
+static const fpoly_row fpoly_empty_row = { 1, 0, 0, 0, 0 };
 
+/**
+ * A factor_poly lives in a single allocation: a header of rows (one
+ * per power of x), followed by one contiguous block of coefficients.
+ * When a row outgrows its slot, it is moved to a new slot at the end
+ * of the block; the block itself grows by doubling, and is compacted
+ * whenever it does.
+ */
 template<class T>
 class factor_poly {
 private:
-  yterms<T> *xterms; 
-  unsigned int nxterms;
-  
-  template<class S> 
+  unsigned char *data;    // the rows, followed by the coefficient block
+  unsigned int nxterms;   // rows in use
+  unsigned int xcapacity; // rows allocated
+  unsigned int nused;     // coefficients handed out from the block
+  unsigned int ncapacity; // coefficients allocated
+  unsigned int nlive;     // coefficients in slots belonging to rows
+
+  template<class S>
   friend bstreambuf &operator<<(bstreambuf &,factor_poly<S> const &);
-  template<class S> 
+  template<class S>
   friend bistream &operator>>(bistream &,factor_poly<S> &);
+  template<class S>
+  friend class factor_poly;
 public:
+  // the same polynomial, with coefficients of type S instead
+  template<class S>
+  struct rebind { typedef factor_poly<S> other; };
+
   /* =============================== */
   /* ========= CONSTRUCTORS ======== */
   /* =============================== */
 
-  factor_poly() {
-    nxterms = 5; // arbitrary ?
-    // create the xterm array
-    xterms = new yterms<T>[nxterms];  
-  }
+  factor_poly() : data(NULL), nxterms(0), xcapacity(0), nused(0), ncapacity(0), nlive(0) {}
 
-  factor_poly(xy_term const &xyt) {
-    nxterms = xyt.xpower+1;
-    // create the xterm array
-    xterms = new yterms<T>[nxterms];  
+  factor_poly(xy_term const &xyt) : data(NULL), nxterms(0), xcapacity(0), nused(0), ncapacity(0), nlive(0) {
     *this += xyt;
   }
 
   factor_poly(factor_poly<T> const &fp) { clone(fp); }
 
-  factor_poly(unsigned int nx, yterms<T> *xts) {
-    nxterms = nx;
-    xterms = xts;
+#ifdef BUI_MOVE_SEMANTICS
+  factor_poly(factor_poly<T> &&fp) BUI_NOEXCEPT : data(fp.data), nxterms(fp.nxterms), xcapacity(fp.xcapacity),
+						nused(fp.nused), ncapacity(fp.ncapacity), nlive(fp.nlive) {
+    fp.data = NULL;
+    fp.nxterms = 0; fp.xcapacity = 0; fp.nused = 0; fp.ncapacity = 0; fp.nlive = 0;
+  }
+#endif
+
+  // convert from another coefficient type, e.g. to recover exact
+  // coefficients from a modular computation.
+  template<class S>
+  explicit factor_poly(factor_poly<S> const &fp) : data(NULL), nxterms(0), xcapacity(0), nused(0), ncapacity(0), nlive(0) {
+    init(fp.nxterms,fp.rows(),false);
+    for(unsigned int i=0;i<nxterms;++i) {
+      T *dst = row_ptr(i);
+      S const *src = fp.row_ptr(i);
+      for(unsigned int j=0;j<rows()[i].size();++j) { dst[j] = T(src[j]); }
+    }
   }
 
   ~factor_poly() { destroy(); }
@@ -422,15 +156,27 @@ public:
 
   factor_poly const &operator=(factor_poly const &src) {
     if(&src != this) {
-      destroy();
-      clone(src);
+      factor_poly<T> tmp(src);
+      swap(tmp);
     }
-    return *this;  
+    return *this;
   }
 
-  void swap(factor_poly<T> &src) {
+#ifdef BUI_MOVE_SEMANTICS
+  factor_poly const &operator=(factor_poly &&src) BUI_NOEXCEPT {
+    // src is about to go away, so it can have our old buffer
+    swap(src);
+    return *this;
+  }
+#endif
+
+  void swap(factor_poly<T> &src) BUI_NOEXCEPT {
+    std::swap(data,src.data);
     std::swap(nxterms,src.nxterms);
-    std::swap(xterms,src.xterms);
+    std::swap(xcapacity,src.xcapacity);
+    std::swap(nused,src.nused);
+    std::swap(ncapacity,src.ncapacity);
+    std::swap(nlive,src.nlive);
   }
 
   /* =============================== */
@@ -439,79 +185,273 @@ public:
 
   void operator+=(xy_term const &p) {
     // make sure enough x terms
-    resize_xterms(p.xpower+1); 
+    resize_xterms(p.xpower+1);
+    // make sure enough y terms
+    resize_row(p.xpower,p.ypower,p.ypowerend);
     // now, do the addition
-    xterms[p.xpower] += p;
+    for(unsigned int i=p.ypower;i<=p.ypowerend;++i) {
+      coefficient(p.xpower,i) += 1;
+    }
   }
 
   void operator+=(factor_poly const &p) {
+    if(&p == this) { factor_poly<T> tmp(p); *this += tmp; return; }
     // make sure enough x terms
-    resize_xterms(p.nxterms); 
+    resize_xterms(p.nxterms);
     for(unsigned int i=0;i<p.nxterms;++i) {
-      if(!p.xterms[i].is_empty()) {
-	xterms[i] += p.xterms[i];
+      fpoly_row const &pr(p.rows()[i]);
+      if(!pr.is_empty()) {
+	resize_row(i,pr.ymin,pr.ymax);
+	yterms_kernels<T>::add(&coefficient(i,pr.ymin),p.row_ptr(i),pr.size());
       }
     }
   }
 
   void operator-=(xy_term const &p) {
     // make sure enough x terms
-    resize_xterms(p.xpower+1); 
+    resize_xterms(p.xpower+1);
+    // make sure enough y terms
+    resize_row(p.xpower,p.ypower,p.ypowerend);
     // now, do the subtraction
-    xterms[p.xpower] -= p;
+    for(unsigned int i=p.ypower;i<=p.ypowerend;++i) {
+      coefficient(p.xpower,i) -= 1;
+    }
   }
 
   void operator-=(factor_poly const &p) {
+    if(&p == this) { factor_poly<T> tmp(p); *this -= tmp; return; }
     // make sure enough x terms
-    resize_xterms(p.nxterms); 
+    resize_xterms(p.nxterms);
     // now do the subtraction
     for(unsigned int i=0;i<p.nxterms;++i) {
-      if(!p.xterms[i].is_empty()) {
-	xterms[i] -= p.xterms[i];
+      fpoly_row const &pr(p.rows()[i]);
+      if(!pr.is_empty()) {
+	resize_row(i,pr.ymin,pr.ymax);
+	yterms_kernels<T>::sub(&coefficient(i,pr.ymin),p.row_ptr(i),pr.size());
       }
     }
   }
 
   void operator*=(biguint coefficient) {
-    for(unsigned int i=0;i<nxterms;++i) { xterms[i] *= coefficient; }
-  }  
+    for(unsigned int i=0;i<nxterms;++i) {
+      if(!rows()[i].is_empty()) {
+	yterms_kernels<T>::scale(row_ptr(i),coefficient,rows()[i].size());
+      }
+    }
+  }
 
   void operator*=(xy_term const &p) {
-    if(p.xpower > 0) { 
-      // need to shift the x's
-      resize_xterms(p.xpower + nxterms + 1); 
-      for(unsigned int i=nxterms;i>p.xpower;--i) {
-	xterms[i-1].swap(xterms[i-(p.xpower+1)]);
+    if(p.xpower > 0 && nxterms > 0) {
+      // need to shift the x's, which only moves the rows
+      unsigned int n = nxterms;
+      resize_xterms(n + p.xpower);
+      fpoly_row *rs = rows();
+      for(unsigned int i=n;i>0;--i) {
+	rs[(i-1)+p.xpower] = rs[i-1];
+      }
+      for(unsigned int i=0;i<p.xpower;++i) { rs[i] = fpoly_empty_row; }
+    }
+    if(p.ypower == p.ypowerend) {
+      // easy case, only a shift required
+      for(unsigned int i=0;i<nxterms;++i) {
+	fpoly_row &r(rows()[i]);
+	if(!r.is_empty()) {
+	  r.ymin += p.ypower;
+	  r.ymax += p.ypowerend;
+	}
+      }
+    } else {
+      // harder case, so build the result in a new block
+      factor_poly<T> r;
+      fpoly_row *shape = rows();
+      for(unsigned int i=0;i<nxterms;++i) {
+	if(!shape[i].is_empty()) {
+	  shape[i].ymin += p.ypower;
+	  shape[i].ymax += p.ypowerend;
+	}
+      }
+      r.init(nxterms,shape,true);
+      unsigned int depth = (p.ypowerend-p.ypower)+1;
+      for(unsigned int i=0;i<nxterms;++i) {
+	fpoly_row const &sr(shape[i]);
+	if(!sr.is_empty()) {
+	  unsigned int width = (sr.ymax - sr.ymin) + 2 - depth;
+	  // each new coefficient is the sum of a window of depth old ones
+	  yterms_kernels<T>::window(r.row_ptr(i),row_ptr(i),width,depth);
+	}
       }
+      swap(r);
     }
-    for(unsigned int i=0;i<nxterms;++i) { xterms[i] *= p; }
-  }  
+    // and we're done!
+  }
 
   /* The more complicated general case
    */
   void operator*=(factor_poly<T> const &p) {
-    if(p.nxterms == 1) {
-      // optimise simple case
-      yterms<T> const &ps(p.xterms[0]);
-      for(unsigned int j=0;j<nxterms;++j) {
-    	xterms[j] *= ps; 
-      }
+    factor_poly<T> r;
+    r.add_product(*this,p);
+    swap(r);
+  }
+
+  /* =============================== */
+  /* ===== MULTIPLY-ACCUMULATE ===== */
+  /* =============================== */
+
+  // this += a * b, without building the product separately
+  void add_product(factor_poly<T> const &a, factor_poly<T> const &b) {
+    if(&a == this || &b == this) {
+      factor_poly<T> tmp(*this);
+      add_product(&a == this ? tmp : a,&b == this ? tmp : b);
+      return;
+    }
+    if(a.nxterms == 0 || b.nxterms == 0) { return; }
+    unsigned int nx = a.nxterms + b.nxterms - 1;
+    unsigned int lo, hi, extra = 0;
+    // first, make room for every row of the product in one go
+    for(unsigned int k=0;k<nx;++k) {
+      if(product_range(a,b,k,lo,hi)) { extra += slot_growth(k,lo,hi); }
+    }
+    reserve(nx,extra);
+    resize_xterms(nx);
+    for(unsigned int k=0;k<nx;++k) {
+      if(product_range(a,b,k,lo,hi)) { resize_row(k,lo,hi); }
+    }
+    // second, accumulate the product itself
+    if(use_kronecker(a,b)) {
+      add_kronecker(a,b);
     } else {
-      factor_poly<T> r;
-      
-      for(unsigned int i=0;i<p.nxterms;++i) {
-	if(p.xterms[i].is_empty()) { continue; }
-	factor_poly<T> tmp(*this);
-	tmp *= xy_term(i,0);
-	yterms<T> const &ps(p.xterms[i]);
-	for(unsigned int j=0;j<tmp.nxterms;++j) {
-	  tmp.xterms[j] *= ps; 
+      add_rows(a,b);
+    }
+  }
+
+  // The two ways add_product can be done (these are public only so
+  // that poly/mul_bench.cpp can time them).  Both need the rows of
+  // this to already cover the product.
+
+  // this += a * b, one pair of rows at a time
+  void add_rows(factor_poly<T> const &a, factor_poly<T> const &b) {
+    for(unsigned int i=0;i<b.nxterms;++i) {
+      fpoly_row const &br(b.rows()[i]);
+      if(br.is_empty()) { continue; }
+      T const *bs = b.row_ptr(i);
+      for(unsigned int j=0;j<a.nxterms;++j) {
+	fpoly_row const &ar(a.rows()[j]);
+	if(ar.is_empty()) { continue; }
+	T *rs = &coefficient(i+j,ar.ymin+br.ymin);
+	dense_mul(rs,a.row_ptr(j),ar.size(),bs,br.size());
+      }
+    }
+  }
+
+  // This += a * b, using Kronecker substitution: putting x = y^s,
+  // where s exceeds the width of every row of the product, turns a and
+  // b into univariate polynomials whose product holds each row of a * b
+  // in its own run of s coefficients.  That product is then done with
+  // dense_mul (and so, Karatsuba's method).
+  void add_kronecker(factor_poly<T> const &a, factor_poly<T> const &b) {
+    unsigned int alo, ahi, blo, bhi;
+    a.yrange(alo,ahi);
+    b.yrange(blo,bhi);
+    unsigned int s = (ahi - alo) + (bhi - blo) + 1;
+    std::vector<T> da, db;
+    a.kronecker(da,s,alo);
+    b.kronecker(db,s,blo);
+    std::vector<T> dr((da.size() + db.size()) - 1,T(UINT32_C(0)));
+    dense_mul(&dr[0],&da[0],da.size(),&db[0],db.size());
+    unsigned int lo, hi;
+    for(unsigned int k=0;k<(a.nxterms+b.nxterms)-1;++k) {
+      if(!product_range(a,b,k,lo,hi)) { continue; }
+      T *rs = &coefficient(k,lo);
+      T const *ds = &dr[(k * s) + (lo - (alo + blo))];
+      yterms_kernels<T>::add(rs,ds,(hi - lo) + 1);
+    }
+  }
+
+  // this += a * t, without building the product separately
+  void add_shifted(factor_poly<T> const &a, xy_term const &t) {
+    if(&a == this) {
+      factor_poly<T> tmp(a);
+      add_shifted(tmp,t);
+      return;
+    }
+    if(a.nxterms == 0) { return; }
+    unsigned int nx = a.nxterms + t.xpower;
+    unsigned int depth = (t.ypowerend - t.ypower) + 1;
+    unsigned int extra = 0;
+    // first, make room for every shifted row in one go
+    for(unsigned int i=0;i<a.nxterms;++i) {
+      fpoly_row const &ar(a.rows()[i]);
+      if(ar.is_empty()) { continue; }
+      extra += slot_growth(i+t.xpower,ar.ymin+t.ypower,ar.ymax+t.ypowerend);
+    }
+    reserve(nx,extra);
+    resize_xterms(nx);
+    // second, add them in
+    for(unsigned int i=0;i<a.nxterms;++i) {
+      fpoly_row const &ar(a.rows()[i]);
+      if(ar.is_empty()) { continue; }
+      unsigned int k = i + t.xpower;
+      unsigned int lo = ar.ymin + t.ypower;
+      resize_row(k,lo,ar.ymax+t.ypowerend);
+      if(depth == 1) {
+	yterms_kernels<T>::add(&coefficient(k,lo),a.row_ptr(i),ar.size());
+      } else {
+	yterms_kernels<T>::window_add(&coefficient(k,lo),a.row_ptr(i),ar.size(),depth);
+      }
+    }
+  }
+
+  // Set this to (this - n) / (xy - x - y), which must divide exactly
+  // with a non-negative quotient t (as in the 2-sum of two Tutte
+  // polynomials, see reduce_2sum).  Since the coefficient of
+  // x^(i+1)y^(j+1) in this - n is t(i,j) - t(i,j+1) - t(i+1,j), the
+  // quotient can be found from the highest powers down, and no value
+  // along the way is ever negative.
+  void divide_2sum(factor_poly<T> const &n) {
+    unsigned int nx = std::max(nxterms,n.nxterms), ny = 0;
+    for(unsigned int i=0;i<nxterms;++i) {
+      if(!rows()[i].is_empty()) { ny = std::max(ny,rows()[i].ymax+1); }
+    }
+    for(unsigned int i=0;i<n.nxterms;++i) {
+      if(!n.rows()[i].is_empty()) { ny = std::max(ny,n.rows()[i].ymax+1); }
+    }
+    if(nx < 2 || ny < 2) { factor_poly<T> tmp; swap(tmp); return; }
+    unsigned int w = ny - 1;
+    std::vector<T> t((nx-1)*w,T(UINT32_C(0)));
+    for(unsigned int i=nx-1;i>0;--i) {
+      for(unsigned int j=ny-1;j>0;--j) {
+	T &c = t[(i-1)*w + (j-1)];
+	T const *p = find(i,j);
+	if(p != NULL) { c = *p; }
+	if(j < w) { c += t[(i-1)*w + j]; }
+	if(i < nx-1) { c += t[i*w + (j-1)]; }
+	p = n.find(i,j);
+	if(p != NULL) { c -= *p; }
+      }
+    }
+    // now, trim the zeros from either end of each row
+    std::vector<fpoly_row> shape(nx-1,fpoly_empty_row);
+    unsigned int rx = 0;
+    for(unsigned int i=0;i<nx-1;++i) {
+      unsigned int lo = 0, hi = w;
+      while(lo < hi && t[i*w + lo] == UINT32_C(0)) { ++lo; }
+      while(hi > lo && t[i*w + hi-1] == UINT32_C(0)) { --hi; }
+      if(lo < hi) {
+	shape[i].ymin = lo;
+	shape[i].ymax = hi-1;
+	rx = i+1;
+      }
+    }
+    factor_poly<T> r;
+    if(rx > 0) {
+      r.init(rx,&shape[0],false);
+      for(unsigned int i=0;i<rx;++i) {
+	for(unsigned int j=shape[i].ymin;j<=shape[i].ymax;++j) {
+	  r.coefficient(i,j) = t[i*w + j];
 	}
-	r += tmp;
       }
-      
-      this->swap(r);
     }
+    swap(r);
   }
 
   factor_poly<T> operator+(factor_poly<T> const &p) const {
@@ -545,66 +485,101 @@ public:
 
   void insert(unsigned int n, xy_term const &p) {
     // make sure enough x terms
-    resize_xterms(p.xpower+1); 
+    resize_xterms(p.xpower+1);
+    // make sure enough y terms
+    resize_row(p.xpower,p.ypower,p.ypowerend);
     // now, do the addition
-    xterms[p.xpower].insert(n,p);
+    for(unsigned int i=p.ypower;i<=p.ypowerend;++i) {
+      coefficient(p.xpower,i) += n;
+    }
   }
-  
+
   std::string compact_str() const {
     std::string r="";
     bool first_time=true;
-    for(unsigned int i=0;i<nxterms;++i) {    
-      if(!xterms[i].is_empty()) {
+    for(unsigned int i=0;i<nxterms;++i) {
+      if(!rows()[i].is_empty()) {
 	if(!first_time) { r += " + "; }
-	first_time=false;    
+	first_time=false;
 	if(i > 0) {
 	  std::stringstream ss;
 	  ss << i;
 	  r += "x^" + ss.str();
 	}
-	r += xterms[i].str();
+	r += row_str(i);
       }
     }
     return r;
   }
 
-  // This method is such an ugly hack!
-  template<class X>
-  std::string utos(X n) const {
-    std::stringstream ss;
-    ss << n;
-    return ss.str();
-  }
-
+  // The whole polynomial is written into a single stream, rather than
+  // building a string for each term.
   std::string str() const {
-    std::string r="";
+    std::ostringstream ss;
     bool first_time=true;
-    for(unsigned int i=0;i<nxterms;++i) {    
-      if(!xterms[i].is_empty()) {
-	std::string xs;
-	if(i > 1) { xs = "*x^" + utos(i); }
-	else if (i == 1) { xs = "*x"; }
-
-	for(unsigned int j=xterms[i].ymin;j<=xterms[i].ymax;++j) {
-	  if(!first_time) { r += " + "; }
-	  first_time=false;    	
-	  std::string ys;
-	  if(j > 1) { ys = "*y^" + utos(j); }
-	  else if(j == 1) { ys = "*y"; }
-	  r += utos(xterms[i][j]) + xs + ys;
+    for(unsigned int i=0;i<nxterms;++i) {
+      fpoly_row const &row(rows()[i]);
+      if(!row.is_empty()) {
+	for(unsigned int j=row.ymin;j<=row.ymax;++j) {
+	  if(!first_time) { ss << " + "; }
+	  first_time=false;
+	  ss << coefficient(i,j);
+	  if(i > 1) { ss << "*x^" << i; }
+	  else if (i == 1) { ss << "*x"; }
+	  if(j > 1) { ss << "*y^" << j; }
+	  else if(j == 1) { ss << "*y"; }
 	}
       }
     }
-    return r;
+    return ss.str();
   }
 
 
   bigint substitute(int32_t x, int32_t y) const {
-    bigint r(INT32_C(0));
-    bigint p(x); 
+    return substitute(std::vector<std::pair<int,int> >(1,std::make_pair(x,y)))[0];
+  }
+
+  // The value at each of the given points, by Horner's rule in both x
+  // and y.  The coefficients are converted just once for the whole
+  // batch and, at each point where no partial sum can exceed 62 bits,
+  // the evaluation is done in int64_t rather than bigint.
+  std::vector<bigint> substitute(std::vector<std::pair<int,int> > const &points) const {
+    std::vector<bigint> r;
+    r.reserve(points.size());
+    std::vector<int64_t> ws;
+    std::vector<bigint> bs;
+    unsigned int cbits = 0, ny = 0, n = 0;
+    bool words = true;
     for(unsigned int i=0;i<nxterms;++i) {
-      bigint x = xterms[i].substitute(y);
-      r += pow(p,i) * x;
+      fpoly_row const &row(rows()[i]);
+      if(row.is_empty()) { continue; }
+      ny = std::max(ny,row.ymax);
+      for(unsigned int j=row.ymin;j<=row.ymax;++j,++n) {
+	biguint c(coefficient(i,j));
+	if(words && c <= (uint64_t) INT64_MAX) {
+	  uint64_t w = c.c_uint64();
+	  ws.push_back(w);
+	  while(cbits < 64 && (w >> cbits) != 0) { ++cbits; }
+	} else {
+	  if(words) {
+	    // too big after all, so start again with bigints
+	    words = false;
+	    bs.assign(ws.begin(),ws.end());
+	  }
+	  bs.push_back(bigint(c));
+	}
+      }
+    }
+    for(unsigned int k=0;k!=points.size();++k) {
+      int32_t x = points[k].first, y = points[k].second;
+      // every partial sum is bounded by n * max|c| * |x|^(nx-1) * |y|^ny
+      unsigned int bits = cbits + ceil_log2(n) + ((nxterms == 0 ? 0 : nxterms-1) * ceil_log2(x)) + (ny * ceil_log2(y));
+      if(words && bits <= 62) {
+	r.push_back(bigint(horner(ws,x,y,(int64_t) 0)));
+      } else {
+	if(bs.size() != n) { bs.assign(ws.begin(),ws.end()); }
+	r.push_back(horner(bs,x,y,bigint(INT32_C(0))));
+      }
     }
     return r;
   }
@@ -612,58 +587,398 @@ public:
   unsigned int nterms() const {
     unsigned int r=0;
     for(unsigned int i=0;i<nxterms;++i) {
-      r += xterms[i].size();
+      r += rows()[i].size();
     }
     return r;
   }
 private:
+  /* =============================== */
+  /* ============ LAYOUT =========== */
+  /* =============================== */
+
+  static unsigned int header_size(unsigned int nx) {
+    unsigned int n = nx * sizeof(fpoly_row);
+    return ((n + FPOLY_ALIGN - 1) / FPOLY_ALIGN) * FPOLY_ALIGN;
+  }
+
+  inline fpoly_row *rows() const { return (fpoly_row *) data; }
+  inline T *block() const { return (T *) (data + header_size(xcapacity)); }
+  // the coefficient of y^ymin in the ith row
+  inline T *row_ptr(unsigned int i) const { return block() + rows()[i].offset; }
+
+  inline T const &coefficient(unsigned int i, unsigned int j) const {
+    return row_ptr(i)[j - rows()[i].ymin];
+  }
+  inline T &coefficient(unsigned int i, unsigned int j) {
+    return row_ptr(i)[j - rows()[i].ymin];
+  }
+
+  // the coefficient of x^i y^j, or NULL if it is outside the rows
+  inline T const *find(unsigned int i, unsigned int j) const {
+    if(i >= nxterms) { return NULL; }
+    fpoly_row const &row(rows()[i]);
+    if(row.is_empty() || j < row.ymin || j > row.ymax) { return NULL; }
+    return &coefficient(i,j);
+  }
+
+  // Evaluate at (x,y), given the coefficients row by row (lowest
+  // power first) as values of type V.
+  template<class V>
+  V horner(std::vector<V> const &cs, int32_t x, int32_t y, V r) const {
+    unsigned int k = cs.size();
+    for(unsigned int i=nxterms;i>0;--i) {
+      fpoly_row const &row(rows()[i-1]);
+      r *= x;
+      if(row.is_empty()) { continue; }
+      V ys(cs[--k]);
+      for(unsigned int j=row.ymax;j>row.ymin;--j) {
+	ys *= y;
+	ys += cs[--k];
+      }
+      for(unsigned int j=0;j<row.ymin;++j) { ys *= y; }
+      r += ys;
+    }
+    return r;
+  }
+
+  // the least b such that |v| <= 2^b
+  static unsigned int ceil_log2(int64_t v) {
+    uint64_t a = (v < 0) ? -v : v;
+    unsigned int b = 0;
+    while(b < 64 && (UINT64_C(1) << b) < a) { ++b; }
+    return b;
+  }
+
+  std::string row_str(unsigned int i) const {
+    std::stringstream ss;
+    fpoly_row const &row(rows()[i]);
+    if(row.ymin != row.ymax) {
+      ss << "y^{" << row.ymin << ".." << row.ymax << "}";
+    } else if(row.ymin == 1) {
+      ss << "y";
+    } else if(row.ymin != 0) {
+      ss << "y^" << row.ymin;
+    }
+    ss << "(";
+    for(unsigned int j=row.ymin;j<=row.ymax;++j) {
+      if(j != row.ymin) { ss << " + "; }
+      ss << coefficient(i,j);
+    }
+    ss << ")";
+    return ss.str();
+  }
+
+  // Allocate space for nx (empty) rows and n zero coefficients.
+  static unsigned char *allocate(unsigned int nx, unsigned int n) {
+    unsigned char *d = (unsigned char *) ::operator new(header_size(nx) + n * sizeof(T));
+    fpoly_allocations()++;
+    fpoly_row *rs = (fpoly_row *) d;
+    for(unsigned int i=0;i<nx;++i) { rs[i] = fpoly_empty_row; }
+    T *b = (T *) (d + header_size(nx));
+    for(unsigned int i=0;i<n;++i) { new (b+i) T(UINT32_C(0)); }
+    return d;
+  }
+
   void destroy() {
-    delete [] xterms; // will invoke yterms destructors 
+    if(data == NULL) { return; }
+    T *b = block();
+    for(unsigned int i=0;i<ncapacity;++i) { b[i].~T(); }
+    ::operator delete(data);
+    data = NULL;
+  }
+
+  // Reset to nx rows, with the given y ranges, and zero coefficients.
+  // The rows are padded if there is likely to be further growth.
+  // Note, shape may point into this poly's existing header.
+  void init(unsigned int nx, fpoly_row const *shape, bool padded) {
+    if(nx == 0) { factor_poly<T> tmp; swap(tmp); return; }
+    unsigned int n = 0;
+    for(unsigned int i=0;i<nx;++i) {
+      if(shape[i].is_empty()) { continue; }
+      unsigned int nyterms = shape[i].size();
+      n += nyterms;
+      if(padded) { n += nyterms * FPOLY_PADDING_FACTOR + std::min(shape[i].ymin,nyterms * FPOLY_PADDING_FACTOR); }
+    }
+    unsigned char *d = allocate(nx,n);
+    fpoly_row *rs = (fpoly_row *) d;
+    unsigned int pos = 0;
+    for(unsigned int i=0;i<nx;++i) {
+      if(shape[i].is_empty()) { continue; }
+      unsigned int nyterms = shape[i].size();
+      fpoly_row &r(rs[i]);
+      r.ymin = shape[i].ymin;
+      r.ymax = shape[i].ymax;
+      r.fpadding = padded ? std::min(r.ymin,nyterms * FPOLY_PADDING_FACTOR) : 0;
+      r.bpadding = padded ? nyterms * FPOLY_PADDING_FACTOR : 0;
+      r.offset = pos + r.fpadding;
+      pos += r.slot();
+    }
+    destroy();
+    data = d;
+    nxterms = nx;
+    xcapacity = nx;
+    nused = n;
+    ncapacity = n;
+    nlive = n;
   }
-  
+
   void clone(factor_poly const &p) {
+    data = NULL;
+    nxterms = 0; xcapacity = 0; nused = 0; ncapacity = 0; nlive = 0;
+    if(p.data == NULL) { return; }
+    // copy each slot (including its padding), dropping any garbage
+    data = allocate(p.nxterms,p.nlive);
     nxterms = p.nxterms;
-    xterms = new yterms<T>[nxterms];
+    xcapacity = p.nxterms;
+    ncapacity = p.nlive;
+    T *b = block();
+    unsigned int pos = 0;
+    for(unsigned int i=0;i<nxterms;++i) {
+      fpoly_row const &pr(p.rows()[i]);
+      if(pr.is_empty()) { continue; }
+      fpoly_row &r(rows()[i]);
+      r = pr;
+      r.offset = pos + pr.fpadding;
+      T const *src = p.block() + (pr.offset - pr.fpadding);
+      for(unsigned int j=0;j<pr.slot();++j) { b[pos+j] = src[j]; }
+      pos += pr.slot();
+    }
+    nused = pos;
+    nlive = pos;
+  }
+
+  // Move everything into a new allocation with room for nx rows and
+  // ncap coefficients (which must cover the live ones).  This also
+  // compacts the block.
+  void rebuild(unsigned int nx, unsigned int ncap) {
+    unsigned int xcap = std::max(nx,nxterms);
+    unsigned char *d = allocate(xcap,ncap);
+    fpoly_row *rs = (fpoly_row *) d;
+    T *b = (T *) (d + header_size(xcap));
+    unsigned int pos = 0;
     for(unsigned int i=0;i<nxterms;++i) {
-      xterms[i] = p.xterms[i];
+      fpoly_row const &r(rows()[i]);
+      if(r.is_empty()) { continue; }
+      rs[i] = r;
+      rs[i].offset = pos + r.fpadding;
+      T *src = block() + (r.offset - r.fpadding);
+      for(unsigned int j=0;j<r.slot();++j) { fpoly_swap(b[pos+j],src[j]); }
+      pos += r.slot();
     }
+    unsigned int n = nxterms;
+    destroy();
+    data = d;
+    nxterms = n;
+    xcapacity = xcap;
+    nused = pos;
+    ncapacity = ncap;
+    nlive = pos;
+  }
+
+  // make sure there is room for nx rows and extra more coefficients
+  void reserve(unsigned int nx, unsigned int extra) {
+    if(nx <= xcapacity && nused + extra <= ncapacity) { return; }
+    // leave room to grow, unless this is the first allocation
+    unsigned int ncap = nlive + extra;
+    if(data != NULL) { ncap = std::max(ncap,2 * nlive); }
+    rebuild(nx,ncap);
   }
 
   void resize_xterms(unsigned int ns) {
-    if(ns < nxterms) { return; }  
-    yterms<T> *xs = new yterms<T>[ns];
-    // need to use swap here, because
-    // I don't want the following delete []
-    // call to call destructors on my yterms
+    if(ns <= nxterms) { return; }
+    if(ns > xcapacity) { rebuild(ns,std::max((unsigned int) FPOLY_MIN_BLOCK,ncapacity)); }
+    for(unsigned int i=nxterms;i<ns;++i) { rows()[i] = fpoly_empty_row; }
+    nxterms = ns;
+  }
+
+  // the room needed for the ith row to include y^lo ... y^hi
+  unsigned int slot_growth(unsigned int i, unsigned int lo, unsigned int hi) const {
+    if(i < nxterms && !rows()[i].is_empty()) {
+      fpoly_row const &r(rows()[i]);
+      if(lo + r.fpadding >= r.ymin && hi <= r.ymax + r.bpadding) { return 0; }
+      lo = std::min(lo,r.ymin);
+      hi = std::max(hi,r.ymax);
+    }
+    unsigned int nyterms = (hi - lo) + 1;
+    return std::min(lo,nyterms * FPOLY_PADDING_FACTOR) + nyterms + nyterms * FPOLY_PADDING_FACTOR;
+  }
+
+  // determine the range of y powers in the kth row of a * b, returning
+  // false if that row is empty.
+  static bool product_range(factor_poly<T> const &a, factor_poly<T> const &b, unsigned int k,
+			    unsigned int &lo, unsigned int &hi) {
+    bool found = false;
+    for(unsigned int i=0;i<b.nxterms && i<=k;++i) {
+      if(k-i >= a.nxterms) { continue; }
+      fpoly_row const &ar(a.rows()[k-i]);
+      fpoly_row const &br(b.rows()[i]);
+      if(ar.is_empty() || br.is_empty()) { continue; }
+      if(!found) {
+	lo = ar.ymin + br.ymin;
+	hi = ar.ymax + br.ymax;
+	found = true;
+      } else {
+	lo = std::min(lo,ar.ymin + br.ymin);
+	hi = std::max(hi,ar.ymax + br.ymax);
+      }
+    }
+    return found;
+  }
+
+  // the smallest range of y powers covering every row
+  void yrange(unsigned int &lo, unsigned int &hi) const {
+    lo = UINT_MAX;
+    hi = 0;
     for(unsigned int i=0;i<nxterms;++i) {
-      xs[i].swap(xterms[i]);
+      fpoly_row const &r(rows()[i]);
+      if(r.is_empty()) { continue; }
+      lo = std::min(lo,r.ymin);
+      hi = std::max(hi,r.ymax);
+    }
+  }
+
+  // Kronecker substitution pays off only when both operands are big,
+  // and not so sparse that the zeros it multiplies dominate.
+  static bool use_kronecker(factor_poly<T> const &a, factor_poly<T> const &b) {
+    unsigned int na = a.nterms(), nb = b.nterms();
+    if(std::min(na,nb) < FPOLY_KRONECKER_THRESHOLD) { return false; }
+    unsigned int alo, ahi, blo, bhi;
+    a.yrange(alo,ahi);
+    b.yrange(blo,bhi);
+    unsigned int s = (ahi - alo) + (bhi - blo) + 1;
+    return (a.nxterms * s) <= (FPOLY_KRONECKER_SPARSITY * na)
+      && (b.nxterms * s) <= (FPOLY_KRONECKER_SPARSITY * nb);
+  }
+
+  // flatten this into d, where y^j x^i goes to d[i*s + j - lo]
+  void kronecker(std::vector<T> &d, unsigned int s, unsigned int lo) const {
+    unsigned int last = 0;
+    for(unsigned int i=0;i<nxterms;++i) {
+      if(!rows()[i].is_empty()) { last = i; }
+    }
+    fpoly_row const &lr(rows()[last]);
+    d.assign((last * s) + (lr.ymax - lo) + 1,T(UINT32_C(0)));
+    for(unsigned int i=0;i<=last;++i) {
+      fpoly_row const &r(rows()[i]);
+      if(r.is_empty()) { continue; }
+      T const *cs = row_ptr(i);
+      T *ds = &d[(i * s) + (r.ymin - lo)];
+      for(unsigned int j=0;j<r.size();++j) { ds[j] = cs[j]; }
+    }
+  }
+
+  // make sure the ith row includes y^n_ymin ... y^n_ymax
+  void resize_row(unsigned int i, unsigned int n_ymin, unsigned int n_ymax) {
+    fpoly_row r = rows()[i];
+    if(!r.is_empty()) {
+      int d_end = n_ymax - r.ymax;
+      int d_beg = r.ymin - n_ymin;
+      unsigned int slot_end = r.offset + r.size() + r.bpadding;
+      if(d_end > (int) r.bpadding && d_beg <= (int) r.fpadding
+	 && slot_end == nused && nused + (d_end - r.bpadding) <= ncapacity) {
+	// this slot is at the end of the block, so just extend it
+	nused += d_end - r.bpadding;
+	nlive += d_end - r.bpadding;
+	rows()[i].bpadding = d_end;
+	r = rows()[i];
+      }
+      if(d_beg <= (int) r.fpadding && d_end <= (int) r.bpadding) {
+	// in this case, there is enough padding to cover it
+	fpoly_row &w(rows()[i]);
+	if(d_end > 0) {
+	  w.ymax = n_ymax;
+	  w.bpadding -= d_end;
+	}
+	if(d_beg > 0) {
+	  w.ymin = n_ymin;
+	  w.offset -= d_beg;
+	  w.fpadding -= d_beg;
+	}
+	return;
+      }
+      n_ymin = std::min(r.ymin,n_ymin);
+      n_ymax = std::max(r.ymax,n_ymax);
+    }
+    // no, there definitely aren't enough y-terms, so make a new slot
+    unsigned int nyterms = (n_ymax - n_ymin) + 1;
+    unsigned int fpadding = std::min(n_ymin,nyterms * FPOLY_PADDING_FACTOR);
+    unsigned int bpadding = nyterms * FPOLY_PADDING_FACTOR;
+    unsigned int slot = fpadding + nyterms + bpadding;
+    if(nused + slot > ncapacity) {
+      rebuild(nxterms,std::max((unsigned int) FPOLY_MIN_BLOCK,2 * (nlive + slot)));
+    }
+    fpoly_row &w(rows()[i]);
+    unsigned int offset = nused + fpadding;
+    if(!w.is_empty()) {
+      // move the old coefficients over, leaving zeros behind
+      T *src = row_ptr(i);
+      T *dst = block() + offset + (w.ymin - n_ymin);
+      for(unsigned int j=0;j<w.size();++j) { fpoly_swap(dst[j],src[j]); }
+      nlive -= w.slot();
     }
-    delete [] xterms;
-    xterms = xs;
-    nxterms = ns;  
-  }  
+    w.ymin = n_ymin;
+    w.ymax = n_ymax;
+    w.offset = offset;
+    w.fpadding = fpadding;
+    w.bpadding = bpadding;
+    nused += slot;
+    nlive += slot;
+  }
 };
 
-template<class T> 
+// The stream holds the number of rows and coefficients, then the range
+// of each row, then the coefficients themselves.  These are packed
+// together, so a lookup reads them back with a single allocation.
+template<class T>
 bstreambuf &operator<<(bstreambuf &bout, factor_poly<T> const &fp) {
-  bout << fp.nxterms;
-  for(unsigned int i=0;i<fp.nxterms;++i) {
-    bout << fp.xterms[i];
+  unsigned int nx = fp.nxterms;
+  while(nx > 0 && fp.rows()[nx-1].is_empty()) { --nx; }
+  bout << nx << fp.nterms();
+  for(unsigned int i=0;i<nx;++i) {
+    bout << fp.rows()[i].ymin << fp.rows()[i].ymax;
+  }
+  for(unsigned int i=0;i<nx;++i) {
+    fpoly_row const &r(fp.rows()[i]);
+    if(r.is_empty()) { continue; }
+    T const *cs = fp.row_ptr(i);
+    if(fpoly_flat<T>::value) {
+      bout.write_bytes(cs,r.size() * sizeof(T));
+    } else {
+      for(unsigned int j=0;j<r.size();++j) { bout << cs[j]; }
+    }
   }
   return bout;
 }
 
-template<class T> 
+template<class T>
 bistream &operator>>(bistream &bin, factor_poly<T> &fp) {
-  unsigned int nxterms;
-  bin >> nxterms;
-  yterms<T> *xterms = new yterms<T>[nxterms];  
-  for(unsigned int i=0;i<nxterms;++i) {
-    bin >> xterms[i];
+  unsigned int nx, n;
+  bin >> nx >> n;
+  factor_poly<T> tmp;
+  if(nx > 0) {
+    tmp.data = factor_poly<T>::allocate(nx,n);
+    tmp.nxterms = nx;
+    tmp.xcapacity = nx;
+    tmp.nused = n;
+    tmp.ncapacity = n;
+    tmp.nlive = n;
+    unsigned int pos = 0;
+    for(unsigned int i=0;i<nx;++i) {
+      fpoly_row &r(tmp.rows()[i]);
+      bin >> r.ymin >> r.ymax;
+      r.offset = pos;
+      pos += r.size();
+    }
+    if(pos != n) { throw std::runtime_error("corrupt polynomial in stream"); }
+    T *cs = tmp.block();
+    if(fpoly_flat<T>::value) {
+      bin.read_bytes(cs,n * sizeof(T));
+    } else {
+      for(unsigned int j=0;j<n;++j) { bin >> cs[j]; }
+    }
   }
   // I do the following swap trick to reduce
   // the number of copy assignments
-  factor_poly<T> tmp(nxterms,xterms);
   fp.swap(tmp);
   return bin;
 }
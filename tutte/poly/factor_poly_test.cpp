@@ -4,11 +4,15 @@
 #include <time.h>
 
 #include "../misc/bigint.hpp"
+#include "../misc/fixed_uint.hpp"
 #include "factor_poly.hpp"
+#include "univariate_poly.hpp"
+#include "simple_poly.hpp"
+#include "eval_poly.hpp"
 
 using namespace std;
 
-typedef enum { ADD, MUL, FULLMUL } aop;
+typedef enum { ADD, MUL, FULLMUL, STREAM, KRONECKER, UNIVARIATE, SIMPLE, DIVIDE, EVAL } aop;
 
 uint32_t random_word(unsigned int max) {
   // i've reduced the size of words produce, since this reflects more
@@ -30,14 +34,140 @@ xy_term random_xy_term(unsigned int width) {
   }
 }
 
-factor_poly<biguint> random_poly(unsigned int length, unsigned int width) {
-  factor_poly<biguint> r(random_xy_term(width));
+template<class P>
+P random_poly(unsigned int length, unsigned int width) {
+  P r(random_xy_term(width));
   for(unsigned int j=0;j!=length;++j) {
     r += random_xy_term(width);
   }
   return r;
 }
 
+factor_poly<biguint> random_poly(unsigned int length, unsigned int width) {
+  return random_poly<factor_poly<biguint> >(length,width);
+}
+
+// Check that a univariate_poly in v agrees with a factor_poly once the
+// other variable is set to zero.
+template<unsigned int V>
+bool univariate_test(unsigned int length, unsigned int width) {
+  unsigned int seed = rand();
+  srand(seed);
+  factor_poly<biguint> f1(random_poly(length,width)), f2(random_poly(length,width));
+  srand(seed);
+  univariate_poly<biguint,V> u1(random_poly<univariate_poly<biguint,V> >(length,width));
+  univariate_poly<biguint,V> u2(random_poly<univariate_poly<biguint,V> >(length,width));
+  xy_term xyt = random_xy_term(width);
+  f1 = (f1 * f2) + (f2 * xyt);
+  u1 = (u1 * u2) + (u2 * xyt);
+  for(int v=-2;v<=2;++v) {
+    int x = (V == UPOLY_X) ? v : 0;
+    int y = (V == UPOLY_Y) ? v : 0;
+    if(f1.substitute(x,y) != u1.substitute(x,y)) { return false; }
+  }
+  bstreambuf bout;
+  bout << u1;
+  bistream bin(bout);
+  bin >> u2;
+  return u1.str() == u2.str();
+}
+
+// Check that a simple_poly agrees with a factor_poly, and survives
+// going through a stream.  The strings can't be compared, since
+// factor_poly also prints zero coefficients within a row.
+bool simple_test(unsigned int length, unsigned int width) {
+  unsigned int seed = rand();
+  srand(seed);
+  factor_poly<biguint> f1(random_poly(length,width)), f2(random_poly(length,width));
+  srand(seed);
+  simple_poly<> s1(random_poly<simple_poly<> >(length,width));
+  simple_poly<> s2(random_poly<simple_poly<> >(length,width));
+  xy_term xyt = random_xy_term(width);
+  f1 = (f1 * f2) + (f2 * xyt);
+  s1 = (s1 * s2) + (s2 * xyt);
+  // the points far from zero need bigints, the others don't
+  int vs[] = { -70000, -1000, -2, -1, 0, 1, 2, 3, 1000 };
+  vector<pair<int,int> > points;
+  for(unsigned int i=0;i!=9;++i) {
+    for(unsigned int j=0;j!=9;++j) {
+      points.push_back(make_pair(vs[i],vs[j]));
+    }
+  }
+  vector<bigint> values = f1.substitute(points);
+  for(unsigned int i=0;i!=points.size();++i) {
+    if(values[i] != s1.substitute(points[i].first,points[i].second)) { return false; }
+  }
+  bstreambuf bout;
+  bout << s1;
+  bistream bin(bout);
+  bin >> s2;
+  return s1 == s2;
+}
+
+// Check that an eval_poly agrees with a factor_poly at each of its
+// points, after each of the operations used in the tutte computation.
+// The points avoid (0,0) and (2,2), where divide_2sum is undefined.
+bool eval_test(unsigned int length, unsigned int width) {
+  int vs[][2] = { {-2,3}, {3,-2}, {-1,-1}, {1,1}, {0,1}, {2,3}, {-1000,7}, {4,-1000} };
+  vector<pair<int,int> > points;
+  for(unsigned int i=0;i!=8;++i) { points.push_back(make_pair(vs[i][0],vs[i][1])); }
+  eval_poly<>::set_points(points);
+  unsigned int seed = rand();
+  srand(seed);
+  factor_poly<biguint> f1(random_poly(length,width)), f2(random_poly(length,width)), f3(random_poly(length,width));
+  srand(seed);
+  eval_poly<> e1(random_poly<eval_poly<> >(length,width));
+  eval_poly<> e2(random_poly<eval_poly<> >(length,width));
+  eval_poly<> e3(random_poly<eval_poly<> >(length,width));
+  xy_term xyt = random_xy_term(width);
+  f1 += f2;
+  e1 += e2;
+  f1 *= xyt;
+  e1 *= xyt;
+  f3.add_product(f1,f2);
+  e3.add_product(e1,e2);
+  f3.add_shifted(f2,xyt);
+  e3.add_shifted(e2,xyt);
+  if(f1.substitute(points) != e1.substitute(points)) { return false; }
+  if(f3.substitute(points) != e3.substitute(points)) { return false; }
+  // as for DIVIDE in primitive_test, with f3 as the quotient
+  factor_poly<biguint> fd(f1 + (f3 * xy_term(1,1))), fn(f1);
+  eval_poly<> ed(e1 + (e3 * xy_term(1,1))), en(e1);
+  fn += f3 * xy_term(1,0);
+  fn += f3 * xy_term(0,1);
+  en += e3 * xy_term(1,0);
+  en += e3 * xy_term(0,1);
+  fd.divide_2sum(fn);
+  ed.divide_2sum(en);
+  return fd.substitute(points) == ed.substitute(points) && ed.substitute(points) == e3.substitute(points);
+}
+
+// Check that products and 2-sum divisions done with fixed_uint
+// coefficients (which wrap) agree with biguint ones, modulo 2^w.  The
+// coefficients of p1 are first scaled up by c, so that they do wrap.
+template<class W>
+bool fixed_test(factor_poly<biguint> p1, factor_poly<biguint> const &p2, biguint const &c, aop op) {
+  typedef factor_poly<fixed_uint<W> > F;
+  p1 *= c;
+  F f1(p1), f2(p2);
+  if(op == KRONECKER) {
+    factor_poly<biguint> r(p1 * p2);
+    F s1(f1 * f2), s2(s1), s3(s1);
+    r.add_rows(p1,p2);
+    s2.add_rows(f1,f2);
+    s3.add_kronecker(f1,f2);
+    return s2.str() == s3.str() && s2.str() == F(r).str();
+  } else {
+    // as for DIVIDE in primitive_test
+    factor_poly<biguint> d(p2 + (p1 * xy_term(1,1))), n(p2);
+    n += p1 * xy_term(1,0);
+    n += p1 * xy_term(0,1);
+    F fd(d);
+    fd.divide_2sum(F(n));
+    return fd.str() == f1.str();
+  }
+}
+
 void primitive_test(unsigned int count, unsigned int length, unsigned int width, aop op, bool verbose) {
   for(unsigned int i=0;i!=count;++i) {
     factor_poly<biguint> p1(random_poly(length,width)*random_poly(length,width)*random_poly(length,width));
@@ -75,6 +205,61 @@ void primitive_test(unsigned int count, unsigned int length, unsigned int width,
       } else if(p1.substitute(2,2) != sum2_2) {
 	cerr << "ERROR(3.2) ********** " << endl;
       }
+    } else if(op == STREAM) {
+      bstreambuf bout;
+      bout << p1;
+      bistream bin(bout);
+      bin >> p2;
+      if(p1.str() != p2.str()) {
+	cerr << "ERROR(4.1) ********** " << endl;
+      }
+    } else if(op == KRONECKER) {
+      // both ways of multiplying must give exactly the same product
+      factor_poly<biguint> r1(p1 * p2), r2(r1), r3(r1);
+      r2.add_rows(p1,p2);
+      r3.add_kronecker(p1,p2);
+      biguint c(UINT32_C(1));
+      for(unsigned int j=0;j!=5;++j) { c *= random_word(1U << 30U) | 1U; }
+      if(r2.str() != r3.str()) {
+	cerr << "ERROR(5.1) ********** " << endl;
+      } else if(!fixed_test<uint64_t>(p1,p2,c,op)) {
+	cerr << "ERROR(5.2) ********** " << endl;
+      } else if(!fixed_test<unsigned __int128>(p1,p2,c,op)) {
+	cerr << "ERROR(5.3) ********** " << endl;
+      }
+    } else if(op == UNIVARIATE) {
+      if(!univariate_test<UPOLY_X>(length,width)) {
+	cerr << "ERROR(6.1) ********** " << endl;
+      } else if(!univariate_test<UPOLY_Y>(length,width)) {
+	cerr << "ERROR(6.2) ********** " << endl;
+      }
+    } else if(op == SIMPLE) {
+      if(!simple_test(length,width)) {
+	cerr << "ERROR(7.1) ********** " << endl;
+      }
+    } else if(op == DIVIDE) {
+      // (p2 + q xy) - (p2 + q x + q y) is exactly q (xy - x - y)
+      biguint c(UINT32_C(1));
+      for(unsigned int j=0;j!=5;++j) { c *= random_word(1U << 30U) | 1U; }
+      if(!fixed_test<uint64_t>(p1,p2,c,op)) {
+	cerr << "ERROR(8.3) ********** " << endl;
+      } else if(!fixed_test<unsigned __int128>(p1,p2,c,op)) {
+	cerr << "ERROR(8.4) ********** " << endl;
+      }
+      factor_poly<biguint> q(p1), n(p2);
+      p1 = p2 + (q * xy_term(1,1));
+      n += q * xy_term(1,0);
+      n += q * xy_term(0,1);
+      p1.divide_2sum(n);
+      if(p1.substitute(2,2) != q.substitute(2,2)) {
+	cerr << "ERROR(8.1) ********** " << endl;
+      } else if(p1.substitute(-1,3) != q.substitute(-1,3)) {
+	cerr << "ERROR(8.2) ********** " << endl;
+      }
+    } else if(op == EVAL) {
+      if(!eval_test(length,width)) {
+	cerr << "ERROR(9.1) ********** " << endl;
+      }
     }
     if(verbose) {
       cout << "=========== POLYNOMIAL ============" << endl << p1.str() << endl;
@@ -157,6 +342,18 @@ int main(int argc, char *argv[]) {
     cout << "PRIM MUL DONE" << endl;
     primitive_test(count,length,width,FULLMUL,verbose);
     cout << "PRIM FULLMUL DONE" << endl;
+    primitive_test(count,length,width,STREAM,verbose);
+    cout << "PRIM STREAM DONE" << endl;
+    primitive_test(count,length,width,KRONECKER,verbose);
+    cout << "PRIM KRONECKER DONE" << endl;
+    primitive_test(count,length,width,UNIVARIATE,verbose);
+    cout << "PRIM UNIVARIATE DONE" << endl;
+    primitive_test(count,length,width,SIMPLE,verbose);
+    cout << "PRIM SIMPLE DONE" << endl;
+    primitive_test(count,length,width,DIVIDE,verbose);
+    cout << "PRIM DIVIDE DONE" << endl;
+    primitive_test(count,length,width,EVAL,verbose);
+    cout << "PRIM EVAL DONE" << endl;
   } catch(exception const &e) {
     cout << "CAUGHT EXCEPTION: " << e.what() << endl;
   }
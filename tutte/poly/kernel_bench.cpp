@@ -0,0 +1,153 @@
+// (C) Copyright David James Pearce and Gary Haggard, 2007.
+// Permission to copy, use, modify, sell and distribute this software
+// is granted provided this copyright notice appears in all copies.
+// This software is provided "as is" without express or implied
+// warranty, and with no claim as to its suitability for any purpose.
+//
+// Email: david.pearce@mcs.vuw.ac.nz
+
+// Microbenchmark for the 64-bit yterms kernels.  Each kernel set
+// supported by this CPU is first checked against the scalar one, and
+// then timed over run lengths drawn from those seen when computing
+// K12, K14 and K16.  To build (in a configured tree):
+//
+//   g++ -O2 kernel_bench.cpp ../misc/biguint.cpp ../misc/bstreambuf.cpp ../misc/bistream.cpp -o kernel_bench
+//   ./kernel_bench
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cstdlib>
+#include <sys/time.h>
+#include "yterms_kernels.hpp"
+
+using namespace std;
+
+double now() {
+  struct timeval tmp;
+  gettimeofday(&tmp,NULL);
+  return tmp.tv_sec + (tmp.tv_usec / 1000000.0);
+}
+
+// The quantiles (10%, 25%, 50%, 75% and 90%) of the run lengths
+// passed to add/sub and of the window depths, as measured for each
+// graph.
+struct profile {
+  char const *name;
+  unsigned int lengths[5];
+  unsigned int depths[5];
+};
+
+static profile profiles[] = {
+  { "K12", { 1, 2, 9, 18, 27 }, { 2, 2, 3, 5, 9 } },
+  { "K14", { 1, 6, 15, 28, 40 }, { 2, 2, 3, 4, 8 } },
+  { "K16", { 2, 10, 23, 40, 54 }, { 2, 2, 2, 4, 5 } }
+};
+
+static char const *kernel_names[] = { "scalar", "avx2", "avx512" };
+
+// pick a value from the given quantiles, interpolating between them
+unsigned int sample(unsigned int const *qs) {
+  static double const ps[] = { 0.1, 0.25, 0.5, 0.75, 0.9 };
+  double p = rand() / (RAND_MAX + 1.0);
+  if(p < ps[0]) { return 1 + rand() % qs[0]; }
+  for(unsigned int i=1;i!=5;++i) {
+    if(p < ps[i]) { return qs[i-1] + rand() % (qs[i] - qs[i-1] + 1); }
+  }
+  return qs[4] + rand() % (qs[4] + 1);
+}
+
+uint64_t random_word() {
+  return (((uint64_t) rand()) << 42U) ^ (((uint64_t) rand()) << 21U) ^ rand();
+}
+
+bool check(u64_kernel_table const &k, u64_kernel_table const &s) {
+  for(unsigned int n=0;n!=80;++n) {
+    vector<uint64_t> a(n+1), b(n+1), c;
+    for(unsigned int i=0;i!=n;++i) { a[i] = random_word(); b[i] = random_word(); }
+    uint64_t m = random_word();
+    c = a; k.add(&c[0],&b[0],n);
+    vector<uint64_t> d(a); s.add(&d[0],&b[0],n);
+    if(c != d) { return false; }
+    c = a; k.sub(&c[0],&b[0],n);
+    d = a; s.sub(&d[0],&b[0],n);
+    if(c != d) { return false; }
+    c = a; k.scale(&c[0],m,n);
+    d = a; s.scale(&d[0],m,n);
+    if(c != d) { return false; }
+    k.prefix(&c[0],&a[0],n);
+    s.prefix(&d[0],&a[0],n);
+    if(c != d) { return false; }
+    for(unsigned int depth=1;n != 0 && depth!=40;++depth) {
+      c = vector<uint64_t>(n+depth-1);
+      d = c;
+      u64_window(k,&c[0],&a[0],n,depth);
+      window_scalar(&d[0],&a[0],n,depth);
+      if(c != d) { return false; }
+    }
+  }
+  return true;
+}
+
+void report(char const *what, double time, unsigned long count) {
+  cout << "  " << setw(10) << left << what << setprecision(3) << ((time * 1000000000) / count) << "ns/op" << endl;
+}
+
+int main(int argc, char *argv[]) {
+  u64_kernel_table scalar;
+  find_u64_kernels("scalar",scalar);
+  cout << "Selected: " << u64_kernels().name << endl;
+
+  unsigned int const nops = 1000000;
+  unsigned int const reps = 20;
+  uint64_t acc = 0;
+
+  for(unsigned int p=0;p!=sizeof(profiles)/sizeof(profile);++p) {
+    // generate the operations up front, so every kernel set sees the same
+    srand(p+1);
+    vector<unsigned int> lengths, widths, depths;
+    for(unsigned int i=0;i!=nops;++i) {
+      lengths.push_back(sample(profiles[p].lengths));
+      widths.push_back(sample(profiles[p].lengths));
+      depths.push_back(sample(profiles[p].depths));
+    }
+    vector<uint64_t> a(256), b(256);
+    for(unsigned int i=0;i!=a.size();++i) { a[i] = random_word(); b[i] = random_word(); }
+
+    for(unsigned int j=0;j!=sizeof(kernel_names)/sizeof(char const *);++j) {
+      u64_kernel_table k;
+      if(!find_u64_kernels(kernel_names[j],k)) { continue; }
+      if(!check(k,scalar)) {
+	cerr << "error: " << k.name << " kernels do not match scalar" << endl;
+	exit(1);
+      }
+      cout << profiles[p].name << " (" << k.name << "):" << endl;
+
+      double start = now();
+      for(unsigned int r=0;r!=reps;++r) {
+	for(unsigned int i=0;i!=nops;++i) { k.add(&a[0],&b[0],lengths[i]); }
+      }
+      report("add",now()-start,(unsigned long) reps*nops);
+
+      start = now();
+      for(unsigned int r=0;r!=reps;++r) {
+	for(unsigned int i=0;i!=nops;++i) { k.sub(&a[0],&b[0],lengths[i]); }
+      }
+      report("sub",now()-start,(unsigned long) reps*nops);
+
+      start = now();
+      for(unsigned int r=0;r!=reps;++r) {
+	for(unsigned int i=0;i!=nops;++i) { k.scale(&a[0],b[i & 255] | 1U,lengths[i]); }
+      }
+      report("scale",now()-start,(unsigned long) reps*nops);
+
+      start = now();
+      for(unsigned int r=0;r!=reps;++r) {
+	for(unsigned int i=0;i!=nops;++i) { u64_window(k,&b[0],&a[0],widths[i],depths[i]); }
+      }
+      report("window",now()-start,(unsigned long) reps*nops);
+      acc += a[0] + b[0];
+    }
+  }
+  cout << "(checksum " << acc << ")" << endl;
+}
@@ -0,0 +1,173 @@
+// (C) Copyright David James Pearce and Gary Haggard, 2007.
+// Permission to copy, use, modify, sell and distribute this software
+// is granted provided this copyright notice appears in all copies.
+// This software is provided "as is" without express or implied
+// warranty, and with no claim as to its suitability for any purpose.
+//
+// Email: david.pearce@mcs.vuw.ac.nz
+
+// Crossover benchmark for polynomial multiplication.  The first part
+// times dense_mul against schoolbook multiplication for a range of
+// lengths; rebuilding with -DDENSE_KARATSUBA_THRESHOLD=<n> (or the
+// _FIXED and _MODVEC variants) shows the effect of other thresholds.
+// The second part times the two ways factor_poly can accumulate a
+// product (row by row, or by Kronecker substitution) on operands
+// shaped like Tutte polynomials (i.e. x^i y^j for i+j <= d), and on
+// dense ones (i.e. i,j <= d), which is what FPOLY_KRONECKER_THRESHOLD
+// and FPOLY_KRONECKER_SPARSITY are chosen from.  To build (in a
+// configured tree):
+//
+//   g++ -O2 mul_bench.cpp ../misc/biguint.cpp ../misc/bstreambuf.cpp ../misc/bistream.cpp -o mul_bench
+//   ./mul_bench
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cstdlib>
+#include <sys/time.h>
+#include "factor_poly.hpp"
+
+using namespace std;
+
+double now() {
+  struct timeval tmp;
+  gettimeofday(&tmp,NULL);
+  return tmp.tv_sec + (tmp.tv_usec / 1000000.0);
+}
+
+// a coefficient of roughly the given number of bits
+template<class T>
+T random_coefficient(unsigned int bits) {
+  biguint r(UINT32_C(1));
+  while(bits > 16) {
+    r *= biguint(UINT32_C(1) << 16U);
+    r += (uint32_t) (rand() & 0xffff);
+    bits -= 16;
+  }
+  return T(r);
+}
+
+// the polynomial with every x^i y^j, where i+j <= d (if triangle)
+// or i,j <= d (otherwise)
+template<class T>
+factor_poly<T> random_poly(unsigned int d, bool triangle, unsigned int bits) {
+  factor_poly<T> r;
+  for(unsigned int i=0;i<=d;++i) {
+    for(unsigned int j=0;j<=(triangle ? d-i : d);++j) {
+      factor_poly<T> t(xy_term(i,j));
+      t *= biguint(random_coefficient<biguint>(bits));
+      r += t;
+    }
+  }
+  return r;
+}
+
+// repeat f until at least 0.2s has passed, giving the time per call
+template<class F>
+double time_of(F const &f) {
+  unsigned int reps = 0;
+  double start = now(), end;
+  do {
+    f();
+    ++reps;
+    end = now();
+  } while(end - start < 0.2);
+  return (end - start) / reps;
+}
+
+template<class T>
+struct dense_case {
+  vector<T> a, b, r;
+  bool karatsuba;
+  void operator()() const {
+    dense_case<T> &self(const_cast<dense_case<T> &>(*this));
+    if(karatsuba) {
+      dense_mul(&self.r[0],&a[0],a.size(),&b[0],b.size());
+    } else {
+      dense_mul_schoolbook(&self.r[0],&a[0],a.size(),&b[0],b.size());
+    }
+  }
+};
+
+template<class T>
+void bench_dense(char const *name, unsigned int bits) {
+  cout << "dense_mul (" << name << ", threshold " << dense_karatsuba_threshold<T>::value << ")" << endl;
+  cout << setw(8) << "length" << setw(14) << "schoolbook" << setw(14) << "karatsuba" << setw(10) << "ratio" << endl;
+  for(unsigned int n=8;n<=1024;n*=2) {
+    dense_case<T> c;
+    for(unsigned int i=0;i<n;++i) {
+      c.a.push_back(random_coefficient<T>(bits));
+      c.b.push_back(random_coefficient<T>(bits));
+    }
+    // check they agree first
+    vector<T> r1((2*n)-1,T(UINT32_C(0))), r2(r1);
+    dense_mul_schoolbook(&r1[0],&c.a[0],n,&c.b[0],n);
+    dense_mul(&r2[0],&c.a[0],n,&c.b[0],n);
+    for(unsigned int i=0;i<r1.size();++i) {
+      if(biguint(r1[i]) != biguint(r2[i])) {
+	cout << "ERROR: dense_mul disagrees with schoolbook at length " << n << endl;
+	exit(1);
+      }
+    }
+    c.r = r1;
+    c.karatsuba = false;
+    double ts = time_of(c);
+    c.karatsuba = true;
+    double tk = time_of(c);
+    cout << setw(8) << n << setw(14) << ts * 1e6 << setw(14) << tk * 1e6
+	 << setw(10) << setprecision(3) << (ts / tk) << endl;
+  }
+}
+
+template<class T>
+struct poly_case {
+  factor_poly<T> a, b, r;
+  bool kronecker;
+  void operator()() const {
+    poly_case<T> &self(const_cast<poly_case<T> &>(*this));
+    if(kronecker) {
+      self.r.add_kronecker(a,b);
+    } else {
+      self.r.add_rows(a,b);
+    }
+  }
+};
+
+template<class T>
+void bench_poly(char const *name, bool triangle, unsigned int bits) {
+  cout << "factor_poly products (" << name << ", " << (triangle ? "triangular" : "dense") << ")" << endl;
+  cout << setw(8) << "degree" << setw(8) << "terms" << setw(14) << "rows"
+       << setw(14) << "kronecker" << setw(10) << "ratio" << endl;
+  for(unsigned int d=4;d<=64;d+=d/2) {
+    poly_case<T> c;
+    c.a = random_poly<T>(d,triangle,bits);
+    c.b = random_poly<T>(d,triangle,bits);
+    // shape r to cover the product, and check both ways agree
+    factor_poly<T> r1(c.a * c.b), r2(r1);
+    r1.add_rows(c.a,c.b);
+    r2.add_kronecker(c.a,c.b);
+    if(r1.str() != r2.str()) {
+      cout << "ERROR: kronecker disagrees with rows at degree " << d << endl;
+      exit(1);
+    }
+    c.r = r1;
+    c.kronecker = false;
+    double ts = time_of(c);
+    c.kronecker = true;
+    double tk = time_of(c);
+    cout << setw(8) << d << setw(8) << c.a.nterms() << setw(14) << ts * 1e6
+	 << setw(14) << tk * 1e6 << setw(10) << setprecision(3) << (ts / tk) << endl;
+  }
+}
+
+int main(int argc, char *argv[]) {
+  srand(1);
+  bench_dense<fixed_uint<uint64_t> >("64-bit",64);
+  bench_dense<modvec<2> >("modvec<2>",120);
+  bench_dense<biguint>("biguint",120);
+  for(unsigned int i=0;i!=2;++i) {
+    bench_poly<fixed_uint<uint64_t> >("64-bit",i==0,64);
+    bench_poly<modvec<2> >("modvec<2>",i==0,120);
+    bench_poly<biguint>("biguint",i==0,120);
+  }
+}
@@ -1,7 +1,7 @@
-// (C) Copyright David James Pearce and Gary Haggard, 2007. 
-// Permission to copy, use, modify, sell and distribute this software 
-// is granted provided this copyright notice appears in all copies. 
-// This software is provided "as is" without express or implied 
+// (C) Copyright David James Pearce and Gary Haggard, 2007.
+// Permission to copy, use, modify, sell and distribute this software
+// is granted provided this copyright notice appears in all copies.
+// This software is provided "as is" without express or implied
 // warranty, and with no claim as to its suitability for any purpose.
 //
 // Email: david.pearce@mcs.vuw.ac.nz
@@ -14,8 +14,15 @@
 #include <sstream>
 #include <string>
 #include <map>
+#include <vector>
+#include <utility>
+#include <stdexcept>
 
 #include "xy_term.hpp"
+#include "../misc/bistream.hpp"
+#include "../misc/bstreambuf.hpp"
+#include "../misc/biguint.hpp"
+#include "../misc/bigint.hpp"
 
 class simple_poly_term {
 public:
@@ -23,49 +30,60 @@ public:
   unsigned short ypower;
 
   simple_poly_term(unsigned short x, unsigned short y) : xpower(x), ypower(y) {}
-  
+
   bool operator<(simple_poly_term const &t) const {
-    return (xpower < t.xpower) || 
+    return (xpower < t.xpower) ||
            (xpower == t.xpower && ypower < t.ypower);
   }
 
   bool operator==(simple_poly_term const &t) const {
-    return (xpower == t.xpower && t.ypower == t.ypower);
+    return (xpower == t.xpower && ypower == t.ypower);
   }
 
   std::string str() const {
     std::stringstream ss;
-    if(xpower > 1) { ss << "x^" << xpower; }
-    else if(xpower == 1) { ss << "x"; }
+    if(xpower > 1) { ss << "*x^" << xpower; }
+    else if(xpower == 1) { ss << "*x"; }
 
-    if(ypower > 1) { ss << "y^" << ypower; }
-    else if(ypower == 1) { ss << "y"; }
+    if(ypower > 1) { ss << "*y^" << ypower; }
+    else if(ypower == 1) { ss << "*y"; }
 
     return ss.str();
   }
 
   double substitute(double x, double y) const {
     return pow(x,(double)xpower) * pow(y,(double) ypower);
-  }  
+  }
 };
 
+/**
+ * A simple_poly is the most straightforward representation of a
+ * polynomial: a map from each term with a nonzero coefficient to that
+ * coefficient.  It makes no assumptions about the shape of the
+ * polynomial, and is kept as a baseline against which the other
+ * representations (e.g. factor_poly) can be checked and benchmarked.
+ */
 
-template<class MAP = std::map<simple_poly_term,unsigned int> >
+template<class MAP = std::map<simple_poly_term,biguint> >
 class simple_poly {
 public:
   typedef typename MAP::iterator iterator;
   typedef typename MAP::const_iterator const_iterator;
+  typedef typename MAP::mapped_type coefficient_t;
 private:
   MAP terms;
+
+  template<class M>
+  friend bistream &operator>>(bistream &,simple_poly<M> &);
 public:
   simple_poly() {}
 
   simple_poly(xy_term const &t) {
-    if(t.xpower > 0 || t.ypower > 0) { terms.insert(std::make_pair(simple_poly_term(t.xpower,t.ypower),1)); }
+    *this += t;
   }
 
   simple_poly(unsigned int n, unsigned int x, unsigned int y) {
-    if(x > 0 || y > 0) { terms.insert(std::make_pair(simple_poly_term(x,y),n)); }
+    if(n != 0) { terms.insert(std::make_pair(simple_poly_term(x,y),coefficient_t(n))); }
   }
 
   simple_poly(simple_poly const &t) {
@@ -73,14 +91,20 @@ public:
   }
 
   simple_poly const &operator=(simple_poly const &src) {
-    if(&src != this) { 
+    if(&src != this) {
       terms = src.terms;
     }
     return *this;
   }
 
+  void swap(simple_poly &src) {
+    terms.swap(src.terms);
+  }
+
   void insert(unsigned int n, xy_term const &t) {
-    terms.insert(std::make_pair(simple_poly_term(t.xpower,t.ypower),n)); 
+    for(unsigned int j=t.ypower;j<=t.ypowerend;++j) {
+      add(simple_poly_term(t.xpower,j),coefficient_t(n));
+    }
   }
 
   size_t nterms() const { return terms.size(); }
@@ -99,63 +123,218 @@ public:
     return terms != g.terms;
   }
 
-  void operator+=(simple_poly const &p1) {    
-    for(const_iterator i(p1.terms.begin());i!=p1.terms.end();++i) {      
-      iterator j = terms.find(i->first);
-      if(j != terms.end()) {
-	j->second += i->second;
-      } else {
-	terms.insert(std::make_pair(i->first,i->second));
-      }
+  /* =============================== */
+  /* ======== ARITHMETIC OPS ======= */
+  /* =============================== */
+
+  void operator+=(xy_term const &t) {
+    insert(1,t);
+  }
+
+  void operator+=(simple_poly const &p1) {
+    for(const_iterator i(p1.terms.begin());i!=p1.terms.end();++i) {
+      add(i->first,i->second);
+    }
+  }
+
+  void operator-=(xy_term const &t) {
+    for(unsigned int j=t.ypower;j<=t.ypowerend;++j) {
+      sub(simple_poly_term(t.xpower,j),coefficient_t(UINT32_C(1)));
+    }
+  }
+
+  void operator-=(simple_poly const &p1) {
+    for(const_iterator i(p1.terms.begin());i!=p1.terms.end();++i) {
+      sub(i->first,i->second);
+    }
+  }
+
+  void operator*=(biguint const &c) {
+    if(c == UINT32_C(0)) { terms.clear(); return; }
+    for(iterator i(terms.begin());i!=terms.end();++i) {
+      i->second *= c;
     }
   }
 
   // this is gary's shift operation
   void operator*=(xy_term const &p2) {
-    if(p2.ypowerend == p2.ypower) {
-      // I don't think the STL strictly would allow this,
-      // but it doesn't hurt!      
-      for(const_iterator i(terms.begin());i!=terms.end();++i) {      
-	simple_poly_term &t((simple_poly_term &)i->first); // ouch ;)
-	t.xpower += p2.xpower;
-	t.ypower += p2.ypower;
+    simple_poly r;
+    r.add_shifted(*this,p2);
+    swap(r);
+  }
+
+  void operator*=(simple_poly const &p) {
+    simple_poly r;
+    r.add_product(*this,p);
+    swap(r);
+  }
+
+  // this += a * b
+  void add_product(simple_poly const &a, simple_poly const &b) {
+    if(&a == this || &b == this) {
+      simple_poly tmp(*this);
+      add_product(&a == this ? tmp : a,&b == this ? tmp : b);
+      return;
+    }
+    for(const_iterator i(a.terms.begin());i!=a.terms.end();++i) {
+      for(const_iterator j(b.terms.begin());j!=b.terms.end();++j) {
+	simple_poly_term t(i->first.xpower + j->first.xpower,i->first.ypower + j->first.ypower);
+	add(t,i->second * j->second);
       }
-    } else {
-      // recursive case (this is an ugly hack)
-      simple_poly p(*this);
+    }
+  }
+
+  // this += a * t
+  void add_shifted(simple_poly const &a, xy_term const &t) {
+    if(&a == this) {
+      simple_poly tmp(a);
+      add_shifted(tmp,t);
+      return;
+    }
+    for(const_iterator i(a.terms.begin());i!=a.terms.end();++i) {
+      for(unsigned int j=t.ypower;j<=t.ypowerend;++j) {
+	add(simple_poly_term(i->first.xpower + t.xpower,i->first.ypower + j),i->second);
+      }
+    }
+  }
 
-      for(unsigned int i=p2.ypower;i!=p2.ypowerend-1;++i) {
-	*this += p;
-	p *= xy_term(0,1);
+  // Set this to (this - n) / (xy - x - y), which must divide exactly
+  // with a non-negative quotient (see factor_poly::divide_2sum).
+  void divide_2sum(simple_poly const &n) {
+    unsigned int nx = 0, ny = 0;
+    for(const_iterator i(terms.begin());i!=terms.end();++i) {
+      nx = std::max<unsigned int>(nx,i->first.xpower+1);
+      ny = std::max<unsigned int>(ny,i->first.ypower+1);
+    }
+    for(const_iterator i(n.terms.begin());i!=n.terms.end();++i) {
+      nx = std::max<unsigned int>(nx,i->first.xpower+1);
+      ny = std::max<unsigned int>(ny,i->first.ypower+1);
+    }
+    simple_poly r;
+    for(unsigned int i=nx;i>1;--i) {
+      for(unsigned int j=ny;j>1;--j) {
+	coefficient_t c(coefficient(i-1,j-1));
+	c += r.coefficient(i-2,j-1);
+	c += r.coefficient(i-1,j-2);
+	c -= n.coefficient(i-1,j-1);
+	if(c != UINT32_C(0)) { r.terms.insert(std::make_pair(simple_poly_term(i-2,j-2),c)); }
       }
-      
-      *this += p;
     }
+    swap(r);
+  }
+
+  simple_poly operator+(simple_poly const &p) const {
+    simple_poly r(*this);
+    r += p;
+    return r;
+  }
+
+  simple_poly operator-(simple_poly const &p) const {
+    simple_poly r(*this);
+    r -= p;
+    return r;
+  }
+
+  simple_poly operator*(xy_term const &p) const {
+    simple_poly r(*this);
+    r *= p;
+    return r;
   }
 
+  simple_poly operator*(simple_poly const &p) const {
+    simple_poly r;
+    r.add_product(*this,p);
+    return r;
+  }
+
+  /* ========================== */
+  /* ======== OTHER OPS ======= */
+  /* ========================== */
+
   const std::string str() const {
     std::stringstream ss;
-    // start with xs
     bool firstTime=true;
-    for(const_iterator i(terms.begin());i!=terms.end();++i) {      
+    for(const_iterator i(terms.begin());i!=terms.end();++i) {
       if(!firstTime) { ss << " + "; }
       firstTime=false;
-      simple_poly_term const &t(i->first);
-      int count = i->second;
-      if(count > 1) { ss << count; }
-      ss << i->first.str();
+      ss << i->second << i->first.str();
     }
-    
-    return ss.str(); 
+
+    return ss.str();
   }
 
-  double substitute(double x, double y) const {
-    double val=0;
-    for(const_iterator i(terms.begin());i!=terms.end();++i) {   
-      val += i->first.substitute(x,y) * i->second;
+  bigint substitute(int32_t x, int32_t y) const {
+    bigint r(INT32_C(0));
+    bigint px(x);
+    bigint py(y);
+    for(const_iterator i(terms.begin());i!=terms.end();++i) {
+      r += bigint(i->second) * pow(px,i->first.xpower) * pow(py,i->first.ypower);
+    }
+    return r;
+  }
+
+  std::vector<bigint> substitute(std::vector<std::pair<int,int> > const &points) const {
+    std::vector<bigint> r;
+    r.reserve(points.size());
+    for(unsigned int i=0;i!=points.size();++i) {
+      r.push_back(substitute(points[i].first,points[i].second));
+    }
+    return r;
+  }
+
+private:
+  coefficient_t coefficient(unsigned int x, unsigned int y) const {
+    const_iterator j = terms.find(simple_poly_term(x,y));
+    if(j == terms.end()) { return coefficient_t(UINT32_C(0)); }
+    return j->second;
+  }
+
+  void add(simple_poly_term const &t, coefficient_t const &c) {
+    iterator j = terms.find(t);
+    if(j != terms.end()) {
+      j->second += c;
+    } else {
+      terms.insert(std::make_pair(t,c));
     }
-    return val;
   }
+
+  // terms whose coefficients cancel out are removed, so that every
+  // term held has a nonzero coefficient
+  void sub(simple_poly_term const &t, coefficient_t const &c) {
+    iterator j = terms.find(t);
+    if(j == terms.end()) {
+      throw std::runtime_error("simple_poly cannot hold negative coefficients");
+    }
+    j->second -= c;
+    if(j->second == UINT32_C(0)) { terms.erase(j); }
+  }
+
+  template<class M>
+  friend bstreambuf &operator<<(bstreambuf &,simple_poly<M> const &);
 };
 
+template<class MAP>
+bstreambuf &operator<<(bstreambuf &bout, simple_poly<MAP> const &p) {
+  bout << (unsigned int) p.terms.size();
+  for(typename simple_poly<MAP>::const_iterator i(p.terms.begin());i!=p.terms.end();++i) {
+    bout << i->first.xpower << i->first.ypower << i->second;
+  }
+  return bout;
+}
+
+template<class MAP>
+bistream &operator>>(bistream &bin, simple_poly<MAP> &p) {
+  unsigned int n;
+  bin >> n;
+  simple_poly<MAP> tmp;
+  for(unsigned int i=0;i<n;++i) {
+    unsigned short x, y;
+    typename simple_poly<MAP>::coefficient_t c;
+    bin >> x >> y >> c;
+    tmp.terms.insert(tmp.terms.end(),std::make_pair(simple_poly_term(x,y),c));
+  }
+  p.swap(tmp);
+  return bin;
+}
+
 #endif
@@ -0,0 +1,359 @@
+// (C) Copyright David James Pearce and Gary Haggard, 2007.
+// Permission to copy, use, modify, sell and distribute this software
+// is granted provided this copyright notice appears in all copies.
+// This software is provided "as is" without express or implied
+// warranty, and with no claim as to its suitability for any purpose.
+//
+// Email: david.pearce@mcs.vuw.ac.nz
+
+#ifndef UNIVARIATE_POLY_HPP
+#define UNIVARIATE_POLY_HPP
+
+#include <string>
+#include <sstream>
+#include <vector>
+#include <utility>
+#include <stdexcept>
+
+#include "xy_term.hpp"
+#include "factor_poly.hpp"
+#include "yterms_kernels.hpp"
+#include "dense_mul.hpp"
+#include "../misc/bistream.hpp"
+#include "../misc/bstreambuf.hpp"
+#include "../misc/biguint.hpp"
+#include "../misc/bigint.hpp"
+
+// the variable a univariate_poly is in
+#define UPOLY_X 0
+#define UPOLY_Y 1
+
+/**
+ * A univariate_poly holds what is left of a polynomial in x and y
+ * once the other variable is set to zero.  That is, a
+ * univariate_poly<T,UPOLY_X> holds P(x,0), which is all the chromatic
+ * computation needs, and a univariate_poly<T,UPOLY_Y> holds P(0,y),
+ * which is all the flow computation needs.  Since setting a variable
+ * to zero commutes with addition and multiplication, every operation
+ * simply drops the terms involving the other variable.
+ *
+ * The coefficients of v^lo ... v^hi are held in a single contiguous
+ * run, with nothing for the terms below v^lo.  This is much smaller
+ * than a factor_poly with one row per x power (as for the chromatic)
+ * or a single row (as for the flow), and makes both cache entries and
+ * arithmetic cheaper.
+ */
+
+template<class T, unsigned int V>
+class univariate_poly {
+private:
+  std::vector<T> coeffs; // coeffs[i] is the coefficient of v^(lo+i)
+  unsigned int lo;
+
+  template<class S, unsigned int W>
+  friend bstreambuf &operator<<(bstreambuf &,univariate_poly<S,W> const &);
+  template<class S, unsigned int W>
+  friend bistream &operator>>(bistream &,univariate_poly<S,W> &);
+  template<class S, unsigned int W>
+  friend class univariate_poly;
+public:
+  // the same polynomial, with coefficients of type S instead
+  template<class S>
+  struct rebind { typedef univariate_poly<S,V> other; };
+
+  /* =============================== */
+  /* ========= CONSTRUCTORS ======== */
+  /* =============================== */
+
+  univariate_poly() : lo(0) {}
+
+  univariate_poly(xy_term const &xyt) : lo(0) {
+    *this += xyt;
+  }
+
+  univariate_poly(univariate_poly<T,V> const &p) : coeffs(p.coeffs), lo(p.lo) {
+    if(!coeffs.empty()) { fpoly_allocations()++; }
+  }
+
+#ifdef BUI_MOVE_SEMANTICS
+  univariate_poly(univariate_poly<T,V> &&p) BUI_NOEXCEPT : lo(p.lo) {
+    coeffs.swap(p.coeffs);
+  }
+#endif
+
+  // convert from another coefficient type, e.g. to recover exact
+  // coefficients from a modular computation.
+  template<class S>
+  explicit univariate_poly(univariate_poly<S,V> const &p) : lo(p.lo) {
+    coeffs.reserve(p.coeffs.size());
+    for(unsigned int i=0;i<p.coeffs.size();++i) { coeffs.push_back(T(p.coeffs[i])); }
+    if(!coeffs.empty()) { fpoly_allocations()++; }
+  }
+
+  /* =============================== */
+  /* ======== ASSIGNMENT OP ======== */
+  /* =============================== */
+
+  univariate_poly const &operator=(univariate_poly const &p) {
+    if(this != &p) {
+      univariate_poly<T,V> tmp(p);
+      swap(tmp);
+    }
+    return *this;
+  }
+
+#ifdef BUI_MOVE_SEMANTICS
+  univariate_poly const &operator=(univariate_poly &&p) BUI_NOEXCEPT {
+    swap(p);
+    return *this;
+  }
+#endif
+
+  void swap(univariate_poly<T,V> &p) BUI_NOEXCEPT {
+    coeffs.swap(p.coeffs);
+    std::swap(lo,p.lo);
+  }
+
+  /* =============================== */
+  /* ======== ARITHMETIC OPS ======= */
+  /* =============================== */
+
+  void operator+=(xy_term const &t) {
+    unsigned int p, q;
+    if(!term_range(t,p,q)) { return; }
+    cover(p,q);
+    for(unsigned int i=p;i<=q;++i) { coeffs[i-lo] += UINT32_C(1); }
+  }
+
+  void operator+=(univariate_poly<T,V> const &p) {
+    if(p.coeffs.empty()) { return; }
+    cover(p.lo,p.hi());
+    yterms_kernels<T>::add(&coeffs[p.lo-lo],&p.coeffs[0],p.coeffs.size());
+  }
+
+  void operator-=(xy_term const &t) {
+    unsigned int p, q;
+    if(!term_range(t,p,q)) { return; }
+    cover(p,q);
+    for(unsigned int i=p;i<=q;++i) { coeffs[i-lo] -= UINT32_C(1); }
+  }
+
+  void operator-=(univariate_poly<T,V> const &p) {
+    if(p.coeffs.empty()) { return; }
+    cover(p.lo,p.hi());
+    yterms_kernels<T>::sub(&coeffs[p.lo-lo],&p.coeffs[0],p.coeffs.size());
+  }
+
+  void operator*=(biguint const &v) {
+    if(coeffs.empty()) { return; }
+    yterms_kernels<T>::scale(&coeffs[0],v,coeffs.size());
+  }
+
+  void operator*=(xy_term const &t) {
+    unsigned int p, q;
+    if(!term_range(t,p,q)) {
+      // the term vanishes, and so does the product
+      univariate_poly<T,V> r;
+      swap(r);
+    } else if(p == q) {
+      if(!coeffs.empty()) { lo += p; }
+    } else {
+      univariate_poly<T,V> r;
+      r.add_shifted(*this,t);
+      swap(r);
+    }
+  }
+
+  void operator*=(univariate_poly<T,V> const &p) {
+    univariate_poly<T,V> r;
+    r.add_product(*this,p);
+    swap(r);
+  }
+
+  /* =============================== */
+  /* ===== MULTIPLY-ACCUMULATE ===== */
+  /* =============================== */
+
+  // this += a * b, without building the product separately
+  void add_product(univariate_poly<T,V> const &a, univariate_poly<T,V> const &b) {
+    if(&a == this || &b == this) {
+      univariate_poly<T,V> tmp(*this);
+      add_product(&a == this ? tmp : a,&b == this ? tmp : b);
+      return;
+    }
+    if(a.coeffs.empty() || b.coeffs.empty()) { return; }
+    cover(a.lo + b.lo,a.hi() + b.hi());
+    dense_mul(&coeffs[(a.lo+b.lo)-lo],&a.coeffs[0],a.coeffs.size(),&b.coeffs[0],b.coeffs.size());
+  }
+
+  // this += a * t, without building the product separately
+  void add_shifted(univariate_poly<T,V> const &a, xy_term const &t) {
+    if(&a == this) {
+      univariate_poly<T,V> tmp(a);
+      add_shifted(tmp,t);
+      return;
+    }
+    unsigned int p, q;
+    if(a.coeffs.empty() || !term_range(t,p,q)) { return; }
+    cover(a.lo + p,a.hi() + q);
+    T *dst = &coeffs[(a.lo+p)-lo];
+    if(p == q) {
+      yterms_kernels<T>::add(dst,&a.coeffs[0],a.coeffs.size());
+    } else {
+      yterms_kernels<T>::window_add(dst,&a.coeffs[0],a.coeffs.size(),(q-p)+1);
+    }
+  }
+
+  // Set this to (this - n) / (xy - x - y), which must divide exactly
+  // (see factor_poly::divide_2sum).  With the other variable set to
+  // zero, the divisor is just -v, and so this is (n - this) / v.
+  void divide_2sum(univariate_poly<T,V> const &n) {
+    univariate_poly<T,V> r(n);
+    r -= *this;
+    if(!r.coeffs.empty()) {
+      if(r.lo > 0) { r.lo--; }
+      else { r.coeffs.erase(r.coeffs.begin()); }
+    }
+    swap(r);
+  }
+
+  univariate_poly<T,V> operator+(univariate_poly<T,V> const &p) const {
+    univariate_poly<T,V> r(*this);
+    r += p;
+    return r;
+  }
+
+  univariate_poly<T,V> operator-(univariate_poly<T,V> const &p) const {
+    univariate_poly<T,V> r(*this);
+    r -= p;
+    return r;
+  }
+
+  univariate_poly<T,V> operator*(xy_term const &p) const {
+    univariate_poly<T,V> r(*this);
+    r *= p;
+    return r;
+  }
+
+  univariate_poly<T,V> operator*(univariate_poly<T,V> const &p) const {
+    univariate_poly<T,V> r;
+    r.add_product(*this,p);
+    return r;
+  }
+
+  /* ========================== */
+  /* ======== OTHER OPS ======= */
+  /* ========================== */
+
+  // This gives the same as factor_poly::str() would for the
+  // corresponding polynomial in x and y.
+  std::string str() const {
+    std::stringstream ss;
+    for(unsigned int i=0;i<coeffs.size();++i) {
+      unsigned int n = lo + i;
+      if(i != 0) { ss << " + "; }
+      ss << coeffs[i];
+      if(n > 1) { ss << "*" << variable() << "^" << n; }
+      else if(n == 1) { ss << "*" << variable(); }
+    }
+    return ss.str();
+  }
+
+  // the other variable is ignored, since it has been set to zero
+  bigint substitute(int32_t x, int32_t y) const {
+    bigint r(INT32_C(0));
+    bigint pv((V == UPOLY_X) ? x : y);
+    for(unsigned int i=coeffs.size();i>0;--i) {
+      r *= pv;
+      r += bigint(coeffs[i-1]);
+    }
+    return r * pow(pv,lo);
+  }
+
+  std::vector<bigint> substitute(std::vector<std::pair<int,int> > const &points) const {
+    std::vector<bigint> r;
+    r.reserve(points.size());
+    for(unsigned int i=0;i!=points.size();++i) {
+      r.push_back(substitute(points[i].first,points[i].second));
+    }
+    return r;
+  }
+
+  unsigned int nterms() const {
+    return coeffs.size();
+  }
+
+private:
+  unsigned int hi() const { return lo + coeffs.size() - 1; }
+
+  static char const *variable() { return (V == UPOLY_X) ? "x" : "y"; }
+
+  // Determine the powers v^p ... v^q which t leaves, once the other
+  // variable is set to zero.  This returns false if there are none.
+  static bool term_range(xy_term const &t, unsigned int &p, unsigned int &q) {
+    if(V == UPOLY_X) {
+      if(t.ypower != 0) { return false; }
+      p = t.xpower;
+      q = t.xpower;
+    } else {
+      if(t.xpower != 0) { return false; }
+      p = t.ypower;
+      q = t.ypowerend;
+    }
+    return true;
+  }
+
+  // make sure the coefficients of v^p ... v^q are held
+  void cover(unsigned int p, unsigned int q) {
+    if(coeffs.empty()) {
+      coeffs.assign((q-p)+1,T(UINT32_C(0)));
+      lo = p;
+      fpoly_allocations()++;
+    } else if(p < lo) {
+      // extend downwards, which means moving everything up
+      unsigned int n_hi = std::max(q,hi());
+      std::vector<T> ncoeffs((n_hi-p)+1,T(UINT32_C(0)));
+      for(unsigned int i=0;i<coeffs.size();++i) { fpoly_swap(ncoeffs[(lo-p)+i],coeffs[i]); }
+      coeffs.swap(ncoeffs);
+      lo = p;
+      fpoly_allocations()++;
+    } else if(q > hi()) {
+      if(((q-lo)+1) > coeffs.capacity()) { fpoly_allocations()++; }
+      coeffs.resize((q-lo)+1,T(UINT32_C(0)));
+    }
+  }
+};
+
+template<class T, unsigned int V>
+bstreambuf &operator<<(bstreambuf &bout, univariate_poly<T,V> const &p) {
+  unsigned int n = p.coeffs.size();
+  bout << p.lo << n;
+  if(n == 0) { return bout; }
+  if(fpoly_flat<T>::value) {
+    bout.write_bytes(&p.coeffs[0],n * sizeof(T));
+  } else {
+    for(unsigned int i=0;i<n;++i) { bout << p.coeffs[i]; }
+  }
+  return bout;
+}
+
+template<class T, unsigned int V>
+bistream &operator>>(bistream &bin, univariate_poly<T,V> &p) {
+  unsigned int lo, n;
+  bin >> lo >> n;
+  univariate_poly<T,V> tmp;
+  if(n > 0) {
+    tmp.lo = lo;
+    tmp.coeffs.resize(n,T(UINT32_C(0)));
+    fpoly_allocations()++;
+    if(fpoly_flat<T>::value) {
+      bin.read_bytes(&tmp.coeffs[0],n * sizeof(T));
+    } else {
+      for(unsigned int i=0;i<n;++i) { bin >> tmp.coeffs[i]; }
+    }
+  }
+  p.swap(tmp);
+  return bin;
+}
+
+#endif
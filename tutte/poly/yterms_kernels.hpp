@@ -0,0 +1,324 @@
+// (C) Copyright David James Pearce and Gary Haggard, 2007.
+// Permission to copy, use, modify, sell and distribute this software
+// is granted provided this copyright notice appears in all copies.
+// This software is provided "as is" without express or implied
+// warranty, and with no claim as to its suitability for any purpose.
+//
+// Email: david.pearce@mcs.vuw.ac.nz
+
+#ifndef YTERMS_KERNELS_HPP
+#define YTERMS_KERNELS_HPP
+
+#include <string>
+#include <cstdlib>
+#include <algorithm>
+#include <stdint.h>
+#include "../misc/biguint.hpp"
+#include "../misc/fixed_uint.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define YTERMS_SIMD
+#include <immintrin.h>
+#endif
+
+/**
+ * These are the inner loops of yterms, operating on contiguous runs
+ * of coefficients.  The generic versions work for any coefficient
+ * type.  For 64-bit fixed width coefficients there are AVX2 and
+ * AVX-512 versions, which are selected at runtime according to what
+ * the CPU supports.
+ */
+
+// dst[i] = src[i-depth+1] + ... + src[i], for i < width+depth-1,
+// where src[j] is taken as zero outside of 0 <= j < width.
+template<class T>
+void window_scalar(T *dst, T const *src, unsigned int width, unsigned int depth) {
+  // going up the triangle
+  T acc = UINT32_C(0);
+  for(unsigned int i=0;i<std::min(width,depth);++i) {
+    acc += src[i];
+    dst[i] = acc;
+  }
+  // free fall (if there is any)
+  for(unsigned int i=width;i<depth;++i) {
+    dst[i] = acc;
+  }
+  // going along the top (if there is one)
+  T sub = UINT32_C(0);
+  for(unsigned int i=depth;i<width;++i) {
+    sub += src[i-depth];
+    acc += src[i];
+    dst[i] = acc - sub;
+  }
+  // going down the triangle
+  for(unsigned int i=std::max(depth,width);i < (width+depth-1);++i) {
+    sub += src[i-depth];
+    dst[i] = acc - sub;
+  }
+}
+
+// As for window_scalar, but adding the sums into dst.
+template<class T>
+void window_add_scalar(T *dst, T const *src, unsigned int width, unsigned int depth) {
+  T acc = UINT32_C(0);
+  for(unsigned int i=0;i < (width+depth-1);++i) {
+    if(i < width) { acc += src[i]; }
+    if(i >= depth) { acc -= src[i-depth]; }
+    dst[i] += acc;
+  }
+}
+
+template<class T>
+struct yterms_kernels {
+  // dst[i] += src[i]
+  static void add(T *dst, T const *src, unsigned int n) {
+    for(unsigned int i=0;i!=n;++i) { dst[i] += src[i]; }
+  }
+
+  // dst[i] -= src[i]
+  static void sub(T *dst, T const *src, unsigned int n) {
+    for(unsigned int i=0;i!=n;++i) { dst[i] -= src[i]; }
+  }
+
+  // dst[i] *= c
+  static void scale(T *dst, biguint const &c, unsigned int n) {
+    for(unsigned int i=0;i!=n;++i) { dst[i] *= c; }
+  }
+
+  static void window(T *dst, T const *src, unsigned int width, unsigned int depth) {
+    window_scalar(dst,src,width,depth);
+  }
+
+  static void window_add(T *dst, T const *src, unsigned int width, unsigned int depth) {
+    window_add_scalar(dst,src,width,depth);
+  }
+};
+
+/* =============================== */
+/* ===== 64-BIT FIXED KERNELS ==== */
+/* =============================== */
+
+// The scalar versions, which are used when no vector unit is available.
+
+inline void u64_add_scalar(uint64_t *dst, uint64_t const *src, unsigned int n) {
+  for(unsigned int i=0;i!=n;++i) { dst[i] += src[i]; }
+}
+
+inline void u64_sub_scalar(uint64_t *dst, uint64_t const *src, unsigned int n) {
+  for(unsigned int i=0;i!=n;++i) { dst[i] -= src[i]; }
+}
+
+inline void u64_scale_scalar(uint64_t *dst, uint64_t c, unsigned int n) {
+  for(unsigned int i=0;i!=n;++i) { dst[i] *= c; }
+}
+
+inline void u64_prefix_scalar(uint64_t *dst, uint64_t const *src, unsigned int n) {
+  uint64_t acc = 0;
+  for(unsigned int i=0;i!=n;++i) { acc += src[i]; dst[i] = acc; }
+}
+
+#ifdef YTERMS_SIMD
+
+__attribute__((target("avx2")))
+inline void u64_add_avx2(uint64_t *dst, uint64_t const *src, unsigned int n) {
+  unsigned int i=0;
+  for(;i+4<=n;i+=4) {
+    __m256i a = _mm256_loadu_si256((__m256i const *) (dst+i));
+    __m256i b = _mm256_loadu_si256((__m256i const *) (src+i));
+    _mm256_storeu_si256((__m256i *) (dst+i),_mm256_add_epi64(a,b));
+  }
+  for(;i!=n;++i) { dst[i] += src[i]; }
+}
+
+__attribute__((target("avx2")))
+inline void u64_sub_avx2(uint64_t *dst, uint64_t const *src, unsigned int n) {
+  unsigned int i=0;
+  for(;i+4<=n;i+=4) {
+    __m256i a = _mm256_loadu_si256((__m256i const *) (dst+i));
+    __m256i b = _mm256_loadu_si256((__m256i const *) (src+i));
+    _mm256_storeu_si256((__m256i *) (dst+i),_mm256_sub_epi64(a,b));
+  }
+  for(;i!=n;++i) { dst[i] -= src[i]; }
+}
+
+// AVX2 has no 64-bit multiply, so build it from 32-bit ones
+__attribute__((target("avx2")))
+inline void u64_scale_avx2(uint64_t *dst, uint64_t c, unsigned int n) {
+  __m256i cl = _mm256_set1_epi64x(c & 0xffffffffU);
+  __m256i ch = _mm256_set1_epi64x(c >> 32U);
+  unsigned int i=0;
+  for(;i+4<=n;i+=4) {
+    __m256i a = _mm256_loadu_si256((__m256i const *) (dst+i));
+    __m256i ah = _mm256_srli_epi64(a,32);
+    __m256i lo = _mm256_mul_epu32(a,cl);
+    __m256i mid = _mm256_add_epi64(_mm256_mul_epu32(ah,cl),_mm256_mul_epu32(a,ch));
+    _mm256_storeu_si256((__m256i *) (dst+i),_mm256_add_epi64(lo,_mm256_slli_epi64(mid,32)));
+  }
+  for(;i!=n;++i) { dst[i] *= c; }
+}
+
+__attribute__((target("avx2")))
+inline void u64_prefix_avx2(uint64_t *dst, uint64_t const *src, unsigned int n) {
+  __m256i carry = _mm256_setzero_si256();
+  unsigned int i=0;
+  for(;i+4<=n;i+=4) {
+    __m256i x = _mm256_loadu_si256((__m256i const *) (src+i));
+    // shift up one lane, then two lanes, adding each time
+    __m256i t = _mm256_permute4x64_epi64(x,0x90); // [x0,x0,x1,x2]
+    x = _mm256_add_epi64(x,_mm256_blend_epi32(t,_mm256_setzero_si256(),0x03));
+    t = _mm256_permute4x64_epi64(x,0x40);         // [x0,x0,x0,x1]
+    x = _mm256_add_epi64(x,_mm256_blend_epi32(t,_mm256_setzero_si256(),0x0f));
+    x = _mm256_add_epi64(x,carry);
+    _mm256_storeu_si256((__m256i *) (dst+i),x);
+    carry = _mm256_permute4x64_epi64(x,0xff);
+  }
+  uint64_t acc = i > 0 ? dst[i-1] : 0;
+  for(;i!=n;++i) { acc += src[i]; dst[i] = acc; }
+}
+
+__attribute__((target("avx512f")))
+inline void u64_add_avx512(uint64_t *dst, uint64_t const *src, unsigned int n) {
+  for(unsigned int i=0;i<n;i+=8) {
+    __mmask8 m = (n-i) >= 8 ? 0xff : (__mmask8) ((1U << (n-i)) - 1);
+    __m512i a = _mm512_maskz_loadu_epi64(m,dst+i);
+    __m512i b = _mm512_maskz_loadu_epi64(m,src+i);
+    _mm512_mask_storeu_epi64(dst+i,m,_mm512_add_epi64(a,b));
+  }
+}
+
+__attribute__((target("avx512f")))
+inline void u64_sub_avx512(uint64_t *dst, uint64_t const *src, unsigned int n) {
+  for(unsigned int i=0;i<n;i+=8) {
+    __mmask8 m = (n-i) >= 8 ? 0xff : (__mmask8) ((1U << (n-i)) - 1);
+    __m512i a = _mm512_maskz_loadu_epi64(m,dst+i);
+    __m512i b = _mm512_maskz_loadu_epi64(m,src+i);
+    _mm512_mask_storeu_epi64(dst+i,m,_mm512_sub_epi64(a,b));
+  }
+}
+
+__attribute__((target("avx512f,avx512dq")))
+inline void u64_scale_avx512(uint64_t *dst, uint64_t c, unsigned int n) {
+  __m512i vc = _mm512_set1_epi64(c);
+  for(unsigned int i=0;i<n;i+=8) {
+    __mmask8 m = (n-i) >= 8 ? 0xff : (__mmask8) ((1U << (n-i)) - 1);
+    __m512i a = _mm512_maskz_loadu_epi64(m,dst+i);
+    _mm512_mask_storeu_epi64(dst+i,m,_mm512_mullo_epi64(a,vc));
+  }
+}
+
+__attribute__((target("avx512f")))
+inline void u64_prefix_avx512(uint64_t *dst, uint64_t const *src, unsigned int n) {
+  __m512i zero = _mm512_setzero_si512();
+  __m512i carry = zero;
+  __m512i last = _mm512_set1_epi64(7);
+  for(unsigned int i=0;i<n;i+=8) {
+    __mmask8 m = (n-i) >= 8 ? 0xff : (__mmask8) ((1U << (n-i)) - 1);
+    __m512i x = _mm512_maskz_loadu_epi64(m,src+i);
+    // shift up by one, two and then four lanes, adding each time.  The
+    // maskz forms are used throughout, since the plain ones leave their
+    // (unused) pass-through operand undefined.
+    x = _mm512_add_epi64(x,_mm512_maskz_alignr_epi64(0xff,x,zero,7));
+    x = _mm512_add_epi64(x,_mm512_maskz_alignr_epi64(0xff,x,zero,6));
+    x = _mm512_add_epi64(x,_mm512_maskz_alignr_epi64(0xff,x,zero,4));
+    x = _mm512_add_epi64(x,carry);
+    _mm512_mask_storeu_epi64(dst+i,m,x);
+    carry = _mm512_maskz_permutexvar_epi64(0xff,last,x);
+  }
+}
+
+#endif
+
+struct u64_kernel_table {
+  char const *name;
+  void (*add)(uint64_t *, uint64_t const *, unsigned int);
+  void (*sub)(uint64_t *, uint64_t const *, unsigned int);
+  void (*scale)(uint64_t *, uint64_t, unsigned int);
+  void (*prefix)(uint64_t *, uint64_t const *, unsigned int);
+};
+
+// Find the kernels with the given name ("scalar", "avx2" or
+// "avx512"), returning false if this CPU does not support them.
+inline bool find_u64_kernels(std::string const &name, u64_kernel_table &r) {
+  if(name == "scalar") {
+    u64_kernel_table k = { "scalar", u64_add_scalar, u64_sub_scalar, u64_scale_scalar, u64_prefix_scalar };
+    r = k;
+    return true;
+  }
+#ifdef YTERMS_SIMD
+  __builtin_cpu_init();
+  if(name == "avx2" && __builtin_cpu_supports("avx2")) {
+    u64_kernel_table k = { "avx2", u64_add_avx2, u64_sub_avx2, u64_scale_avx2, u64_prefix_avx2 };
+    r = k;
+    return true;
+  } else if(name == "avx512" && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq")) {
+    u64_kernel_table k = { "avx512", u64_add_avx512, u64_sub_avx512, u64_scale_avx512, u64_prefix_avx512 };
+    r = k;
+    return true;
+  }
+#endif
+  return false;
+}
+
+// Pick the best kernels for this CPU.  Setting YTERMS_KERNELS in the
+// environment overrides this (for benchmarking).
+inline u64_kernel_table select_u64_kernels() {
+  u64_kernel_table r;
+  char const *force = getenv("YTERMS_KERNELS");
+  if(force != NULL && find_u64_kernels(force,r)) { return r; }
+  if(find_u64_kernels("avx512",r) || find_u64_kernels("avx2",r)) { return r; }
+  find_u64_kernels("scalar",r);
+  return r;
+}
+
+inline u64_kernel_table const &u64_kernels() {
+  static u64_kernel_table kernels = select_u64_kernels();
+  return kernels;
+}
+
+// As for window_scalar, but computed from the prefix sums of src:
+// dst[i] = prefix[min(i,width-1)] - prefix[i-depth].  This only pays
+// off for wider windows.
+inline void u64_window(u64_kernel_table const &k, uint64_t *dst, uint64_t const *src, unsigned int width, unsigned int depth) {
+  if(depth < 8) {
+    window_scalar(dst,src,width,depth);
+    return;
+  }
+  unsigned int n = width+depth-1;
+  k.prefix(dst,src,width);
+  for(unsigned int i=width;i<n;++i) { dst[i] = dst[width-1]; }
+  // Work downwards in blocks of at most depth, so the prefix sums
+  // being subtracted are never overwritten first.
+  unsigned int i=n;
+  while(i > depth) {
+    unsigned int start = std::max(depth,i-depth);
+    k.sub(dst+start,dst+start-depth,i-start);
+    i = start;
+  }
+}
+
+template<>
+struct yterms_kernels<fixed_uint<uint64_t> > {
+  typedef fixed_uint<uint64_t> T;
+
+  static void add(T *dst, T const *src, unsigned int n) {
+    u64_kernels().add((uint64_t *) dst,(uint64_t const *) src,n);
+  }
+
+  static void sub(T *dst, T const *src, unsigned int n) {
+    u64_kernels().sub((uint64_t *) dst,(uint64_t const *) src,n);
+  }
+
+  static void scale(T *dst, biguint const &c, unsigned int n) {
+    u64_kernels().scale((uint64_t *) dst,T(c).c_word(),n);
+  }
+
+  static void window(T *dst, T const *src, unsigned int width, unsigned int depth) {
+    u64_window(u64_kernels(),(uint64_t *) dst,(uint64_t const *) src,width,depth);
+  }
+
+  static void window_add(T *dst, T const *src, unsigned int width, unsigned int depth) {
+    window_add_scalar((uint64_t *) dst,(uint64_t const *) src,width,depth);
+  }
+};
+
+#endif
@@ -98,44 +98,95 @@ unsigned int reduce_loops(G &graph) {
   return c;
 }
 
-// THIS ALGORITHM IS BROKEN!
+// Trace out the line through vertex v, which must have exactly two
+// neighbours.  A line is a maximal path whose internal vertices have
+// exactly two neighbours each; its edges are returned in order from
+// one end to the other, with their multiplicities, so that
+// line[i].second == line[i+1].first.  If v lies on a cycle of such
+// vertices, then the line comes back round to where it started and
+// its two ends are the same vertex.
 template<class G>
-line_t trace_line(unsigned int v, unsigned int u, G const &graph) {  
+line_t trace_line(unsigned int v, G const &graph) {  
   // This is a crude, O(v) time algorithm for tracing out a line in the graph.
   line_t line;
-  if(graph.num_edges(v) != 2) { v = u; }
   unsigned int start=v; // needed to protect against cycles
 
-  // First, find one end of the line  
+  // First, find one end of the line, by walking away from w
   unsigned int w = graph.begin_edges(v)->first;
   
   while(graph.num_underlying_edges(v) == 2) {    
-    // determine edge from w
     typename G::edge_iterator i(graph.begin_edges(v));
-    unsigned int u = i->first;
-    if(u == w) { u = (++i)->first; }
+    if(i->first == w) { ++i; }
     w = v;
-    v = u;
+    v = i->first;
     if(v == start) { break; }
   }
 
-  // Second, traverse the entire line
+  // Second, traverse the entire line back from that end
   start = v;
   std::swap(v,w);
-  line.push_back(make_triple(w,v,graph.num_edges(w,v)));
+  line.push_back(edge_t(w,v,graph.num_edges(w,v)));
 
-  while(graph.num_underlying_edges(v) == 2) {
-    // determine edge from w
+  while(v != start && graph.num_underlying_edges(v) == 2) {
     typename G::edge_iterator i(graph.begin_edges(v));
-    unsigned int u = i->first;
-    if(u == w) { u = (++i)->first; }
+    if(i->first == w) { ++i; }
     w = v;
-    v = u;
-    line.push_back(make_triple(w,v,i->second)); 
-    if(v == start) { break; }
+    v = i->first;
+    line.push_back(edge_t(w,v,i->second)); 
   }  
 
   return line;
 }
 
+// Reduce a line, which is not a cycle and not a bridge, to a single
+// "generalised edge".  Deleting and contracting each edge of the line
+// in turn, from the first, gives
+//
+//   T(G) = A * T(G - line) + C * T(G / line)
+//
+// where, if edge i has multiplicity m_i, c_i = 1 + y + ... + y^(m_i-1)
+// is its contract weight and b_i = x + y + ... + y^(m_i-1) is its
+// weight as a bridge (which it becomes once an earlier edge is
+// deleted).  Then, C is the product of the c_i, and A is the sum over
+// j of c_1 * ... * c_(j-1) * b_(j+1) * ... * b_k.  Both are found
+// in a single pass.
+template<class P>
+void reduce_line(P const &X_p, line_t const &line, P &A, P &C) {
+  A = Y(0);
+  C = Y(0,line[0].third-1);
+
+  for(unsigned int k=1;k<line.size();++k) {
+    P b = X_p;
+    if(line[k].third > 1) { b += Y(1,line[k].third-1); }
+    A *= b;
+    A += C;
+    C *= Y(0,line[k].third-1);
+  }
+}
+
+// Combine the polynomials of the two sides of a 2-sum.  If {u,v} is a
+// separation pair of G, splitting it into H1 and H2 (each with its own
+// copy of u and v), and Hi' is Hi with u and v identified, then
+//
+//   (xy - x - y) * T(G) = ((y-1) T(H2) - T(H2')) * T(H1)
+//                       + ((x-1) T(H2') - T(H2)) * T(H1')
+//
+// The right-hand side is split into y T1 T2 + x T1' T2' and
+// (T1 + T1')(T2 + T2'), so that no coefficient goes negative before
+// the (exact) division.
+template<class P>
+P reduce_2sum(P const &t1, P const &t1c, P const &t2, P const &t2c) {
+  P r, xs, n;
+  r.add_product(t1,t2);
+  r *= Y(1);
+  xs.add_product(t1c,t2c);
+  r.add_shifted(xs,X(1));
+  P s1(t1), s2(t2);
+  s1 += t1c;
+  s2 += t2c;
+  n.add_product(s1,s2);
+  r.divide_2sum(n);
+  return r;
+}
+
 #endif
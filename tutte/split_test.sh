@@ -0,0 +1,28 @@
+#!/bin/sh
+# Check that the split modes (-s) use initialisation graphs.  K6 is
+# given as an initialisation graph ahead of K6 itself, so splitting
+# must find it in the cache and print no graphs, whereas without it
+# K6 is split into several smaller ones.  To run (in a built tree):
+#
+#   sh split_test.sh [path to tutte]
+
+TUTTE=${1:-./tutte}
+K6="0--1,0--2,0--3,0--4,0--5,1--2,1--3,1--4,1--5,2--3,2--4,2--5,3--4,3--5,4--5"
+INPUT=/tmp/split_test.$$
+trap 'rm -f $INPUT' 0
+
+# the initialisation graph, in tutte's own output format, then K6
+echo "$K6" | $TUTTE --stdin | grep "^[GT]P*\[" > $INPUT
+echo "$K6" >> $INPUT
+
+status=0
+for flags in "" "--flow"; do
+  with=`$TUTTE $flags -s5 $INPUT | wc -l`
+  without=`echo "$K6" | $TUTTE $flags -s5 --stdin | wc -l`
+  if [ $with -ne 0 ] || [ $without -eq 0 ]; then
+    echo "ERROR: -s5 $flags gave $with graphs with K6 initialised, $without without"
+    status=1
+  fi
+done
+echo "SPLIT INIT DONE"
+exit $status
@@ -16,6 +16,7 @@
 #include <algorithm>
 #include <climits>
 #include <cstdlib>
+#include <cmath>
 #include <csignal>
 #include <getopt.h>
 #include <sys/time.h>
@@ -26,9 +27,13 @@
 #include "graph/spanning_graph.hpp"
 #include "poly/simple_poly.hpp"
 #include "poly/factor_poly.hpp"
+#include "poly/univariate_poly.hpp"
+#include "poly/eval_poly.hpp"
 #include "graph/algorithms.hpp"
 #include "cache/simple_cache.hpp"
 #include "misc/biguint.hpp"
+#include "misc/modvec.hpp"
+#include "misc/fixed_uint.hpp"
 #include "misc/bigint.hpp"
 
 #include "reductions.hpp"
@@ -74,6 +79,13 @@ public:
   }  
 };
 
+// the maximum resident set size so far, in kilobytes
+long peak_memory() {
+  struct rusage ru;
+  getrusage(RUSAGE_SELF,&ru);
+  return ru.ru_maxrss;
+}
+
 // ---------------------------------------------------------------
 // Global Variables
 // ---------------------------------------------------------------
@@ -85,6 +97,8 @@ unsigned int resize_stats = 0;
 unsigned long num_steps = 0;
 unsigned long num_bicomps = 0;
 unsigned long num_cycles = 0;
+unsigned long num_lines = 0;
+unsigned long num_2sums = 0;
 unsigned long num_disbicomps = 0;
 unsigned long num_trees = 0;
 unsigned long num_completed = 0;
@@ -99,7 +113,18 @@ static unsigned int small_graph_threshold = 5;
 static edgesel_t edge_selection_heuristic = AUTO;
 static edgesel_t edge_addition_heuristic = AUTO;
 static simple_cache cache(1024*1024,100);
+static simple_cache table(1024*1024,1000); // small graph table (never evicted)
+static unsigned int table_threshold = 0;   // largest graph size held in table
+static unsigned int table_write_threshold = 7;
+static ostream *table_out = NULL;          // where newly computed entries go
+static unsigned int table_id = 0;
 static vector<pair<int,int> > evalpoints;
+static bool eval_only=false; // only compute values at evalpoints
+static bool modular_mode=false;
+static bool fixed_mode=true; // use fixed width coefficients where they suffice
+static unsigned int cache_rep=0; // representation of polynomials in cache (see REP_*)
+static vector<pair<string,string> > init_graphs; // initialisation graphs, for reloading the cache
+static string table_text; // small graph table, for reloading
 static vector<unsigned int> cache_hit_sizes;
 static unsigned int ngraphs_completed=0;  
 static unsigned int split_threshold=0;
@@ -107,6 +132,8 @@ static bool status_flag=false;
 static bool verbose=true;
 static bool reduce_multicycles=true;
 static bool reduce_multiedges=true;
+static bool reduce_lines=false;
+static bool reduce_2cuts=false;
 static bool use_add_contract=false;
 static bool xml_flag=false;
 static unsigned int tree_id = 2;
@@ -123,6 +150,13 @@ static bool cache_full_stats = false;
 #define MODE_TUTTEX 5
 static int mode = MODE_TUTTE;
 
+#define REP_NONE 0      // cache and table need (re)loading
+#define REP_OTHER 1     // the polynomial type given to run
+#define REP_BIGUINT 2
+#define REP_UINT64 3
+#define REP_UINT128 4
+#define REP_MODVEC 5    // plus the number of primes
+
 void print_status();
 
 // ---------------------------------------------------------------
@@ -239,6 +273,45 @@ void write_tree_end(unsigned int tid) {
   }
 }
 
+// ---------------------------------------------------------------
+// Small Graph Table
+// ---------------------------------------------------------------
+
+/* The small graph table holds polynomials for small biconnected
+ * graphs, indexed by canonical key.  Unlike the cache, it is never
+ * evicted or reset and is consulted regardless of the
+ * small_graph_threshold.  Thus, once the recursion reaches a graph in
+ * the table it terminates with a single lookup.  The table is loaded
+ * from a file in the output format (see load_table), and can be
+ * extended by writing out the small graphs encountered during a
+ * computation.
+ *
+ * Graphs below the small_graph_threshold have no cache key, and so
+ * one is made here and returned in tkey.  The caller keeps it (for
+ * storing the graph in the table later) and frees it, so that no
+ * graph is keyed twice.
+ */
+
+template<class G, class P>
+bool lookup_table(G const &graph, unsigned char const *key, unsigned char *&tkey, P &r) {
+  if(graph.num_vertices() > table_threshold) { return false; }
+  unsigned int id;
+  if(key == NULL) {
+    if(tkey == NULL) { tkey = graph_key(graph); }
+    key = tkey;
+  }
+  return table.lookup(key,r,id);
+}
+
+template<class P>
+void store_table(unsigned char const *key, string const &gstr, P const &poly) {
+  unsigned int id = 0;
+  table.store(key,poly,id);
+  table_id = table_id + 1;
+  *table_out << "G[" << table_id << "] := {" << gstr << "}" << endl;
+  *table_out << "TP[" << table_id << "] := " << poly.str() << " :" << endl;
+}
+
 // ---------------------------------------------------------------
 // SELECT EDGE
 // ---------------------------------------------------------------
@@ -374,6 +447,28 @@ typename G::edge_t select_edge(G const &graph) {
   return r;
 } 
 
+// ---------------------------------------------------------------
+// SELECT LINE
+// ---------------------------------------------------------------
+
+/* This method looks for a line (see trace_line) which can be deleted
+ * and contracted in one go, returning an empty line if there is none.
+ */
+
+template<class G>
+line_t select_line(G const &graph) {
+  // assumes this graph is biconnected
+  for(typename G::vertex_iterator i(graph.begin_verts());i!=graph.end_verts();++i) {
+    if(graph.num_underlying_edges(*i) == 2) {
+      line_t line = trace_line(*i,graph);
+      // the two ends can only be the same if the graph is a cycle
+      if(line[0].first != line[line.size()-1].second) { return line; }
+      break;
+    }
+  }
+  return line_t();
+}
+
 template<class G>
 typename G::edge_t select_missing_edge(G const &graph) {
   unsigned int best(0);
@@ -471,11 +566,12 @@ P tutte(G &graph, unsigned int mid) {
 
   // === 1. APPLY SIMPLIFICATIONS ===
 
-  P RF = Y(reduce_loops(graph));
+  xy_term RF = Y(reduce_loops(graph));
 
   // === 2. CHECK IN CACHE ===
 
   unsigned char *key = NULL;
+  unsigned char *tkey = NULL; // key for the table only (see lookup_table)
   if(graph.num_vertices() >= small_graph_threshold && !graph.is_multitree()) {      
     key = graph_key(graph); 
     unsigned int match_id;
@@ -485,11 +581,13 @@ P tutte(G &graph, unsigned int mid) {
       if(write_tree) { write_tree_match(mid,match_id,graph,cout); }
       delete [] key; // free space used by key
       cache_hit_sizes[graph.num_vertices()]++;
-      return r * RF;
+      r *= RF;
+      return r;
     } 
   }
   
   P poly;
+  unsigned int su, sv, sw; // separation pair, and a vertex on one side
 
   // === 3. CHECK FOR ARTICULATIONS, DISCONNECTS AND/OR TREES ===
 
@@ -524,30 +622,76 @@ P tutte(G &graph, unsigned int mid) {
 	poly *= tutte<G,P>(*i,tid++);      
       }
     }
+  } else if(lookup_table(graph,key,tkey,poly)) {
+    if(write_tree) { write_tree_leaf(mid,graph,cout); }
+  } else if(reduce_2cuts && graph.separation_pair(su,sv,sw,2)) {
+    // split on the 2-vertex cut {su,sv}, computing both sides with
+    // su and sv kept apart and identified (see reduce_2sum).
+    num_2sums++;
+    unsigned int tid = tree_id;
+    tree_id = tree_id + 4;
+    if(write_tree) { write_tree_nonleaf(mid,tid,4,graph,cout); }
+
+    G h1 = graph.split_off(su,sv,sw);
+    G h1c(h1), h2c(graph);
+    h1c.identify(su,sv);
+    h2c.identify(su,sv);
+
+    P t1 = tutte<G,P>(h1, tid);
+    P t1c = tutte<G,P>(h1c, tid+1);
+    P t2 = tutte<G,P>(graph, tid+2);
+    P t2c = tutte<G,P>(h2c, tid+3);
+    poly = reduce_2sum<P>(t1,t1c,t2,t2c);
   } else {
     // TREE OUTPUT STUFF
     unsigned int lid = tree_id;
     unsigned int rid = tree_id+1;
     tree_id = tree_id + 2; // allocate id's now so I know them!
     if(write_tree) { write_tree_nonleaf(mid,lid,2,graph,cout); }
+
+    // record small graphs for the table before they are modified
+    bool write_table = table_out != NULL && graph.num_vertices() <= table_write_threshold;
+    string tstr;
+    if(write_table) {
+      if(key == NULL && tkey == NULL) { tkey = graph_key(graph); }
+      tstr = input_graph_str(graph);
+    }
     
     // === 4. PERFORM DELETE / CONTRACT ===
     
     G g2(graph); 
-    edge_t edge = select_edge(graph);
+    line_t line;
+    if(reduce_lines) { line = select_line(graph); }
+
+    if(line.size() > 1) {
+      // delete/contract the whole line in one go, rather than
+      // one edge at a time
+      num_lines++;
+      P A, C;
+      reduce_line<P>(X(1),line,A,C);
+      graph.remove_line(line);
+      g2.contract_line(line);
+
+      poly.add_product(tutte<G,P>(graph, lid),A);
+      poly.add_product(tutte<G,P>(g2, rid),C);
+    } else {
+      edge_t edge = select_edge(graph);
 
-    // now, delete/contract on the edge's endpoints
-    graph.remove_edge(edge);
-    g2.contract_edge(edge);
+      // now, delete/contract on the edge's endpoints
+      graph.remove_edge(edge);
+      g2.contract_edge(edge);
 
-    // recursively compute the polynomial, starting with delete       
-    if(edge.third > 1) { 
-      poly = tutte<G,P>(graph, lid);
-      poly += (tutte<G,P>(g2, rid) * Y(0,edge.third-1));
-    } else {
-      poly = tutte<G,P>(graph, lid);
-      poly += tutte<G,P>(g2, rid);
+      // recursively compute the polynomial, starting with delete       
+      if(edge.third > 1) { 
+	poly = tutte<G,P>(graph, lid);
+	poly.add_shifted(tutte<G,P>(g2, rid),Y(0,edge.third-1));
+      } else {
+	poly = tutte<G,P>(graph, lid);
+	poly += tutte<G,P>(g2, rid);
+      }
     }
+
+    if(write_table) { store_table(key != NULL ? key : tkey,tstr,poly); }
   }
 
   // Finally, save computed polynomial
@@ -558,8 +702,10 @@ P tutte(G &graph, unsigned int mid) {
     cache.store(key,poly,mid);
     delete [] key;  // free space used by key
   }    
+  delete [] tkey;
 
-  return poly * RF;
+  poly *= RF;
+  return poly;
 }
 
 template<class G, class P>
@@ -568,7 +714,8 @@ void tutteSearch(G &graph, vector<G> &graphs) {
 
   // === 1. APPLY SIMPLIFICATIONS ===
 
-  P RF = Y(reduce_loops(graph));
+  // the loops only matter to the polynomial, which isn't computed here
+  reduce_loops(graph);
 
   // === 2. CHECK IN CACHE ===
 
@@ -648,11 +795,12 @@ P flow(G &graph, unsigned int mid) {
 
   // === 1. APPLY SIMPLIFICATIONS ===
 
-  P RF = Y(reduce_loops(graph));
+  xy_term RF = Y(reduce_loops(graph));
 
   // === 2. CHECK IN CACHE ===
 
   unsigned char *key = NULL;
+  unsigned char *tkey = NULL; // key for the table only (see lookup_table)
   if(graph.num_vertices() >= small_graph_threshold && !graph.is_multitree()) {      
     key = graph_key(graph); 
     unsigned int match_id;
@@ -661,7 +809,8 @@ P flow(G &graph, unsigned int mid) {
       if(write_tree) { write_tree_match(mid,match_id,graph,cout); }
       delete [] key; // free space used by key
       cache_hit_sizes[graph.num_vertices()]++;
-      return r * RF;
+      r *= RF;
+      return r;
     }
   }
 
@@ -721,6 +870,8 @@ P flow(G &graph, unsigned int mid) {
 	poly *= flow<G,P>(*i,tid++);      
       }
     }
+  } else if(lookup_table(graph,key,tkey,poly)) {
+    if(write_tree) { write_tree_leaf(mid,graph,cout); }
   } else {
 
     // TREE OUTPUT STUFF
@@ -732,17 +883,35 @@ P flow(G &graph, unsigned int mid) {
     // === 4. PERFORM DELETE / CONTRACT ===
     
     G g2(graph); 
-    edge_t edge = select_edge(graph);
-
-    // now, delete/contract on the line's endpoints
-    graph.remove_edge(edge);
-    g2.contract_edge(edge);
-    // recursively compute the polynomial   
-    if(edge.third > 1) { 
-      poly = flow<G,P>(graph, lid) + (flow<G,P>(g2, rid) * Y(0,edge.third-1));
+    line_t line;
+    if(reduce_lines) { line = select_line(graph); }
+
+    if(line.size() > 1) {
+      // as for tutte, but a bridge is worth nothing here
+      num_lines++;
+      P A, C;
+      reduce_line<P>(P(),line,A,C);
+      graph.remove_line(line);
+      g2.contract_line(line);
+      // recursively compute the polynomial, starting with contract
+      P contracted = flow<G,P>(g2, rid);
+      poly.add_product(flow<G,P>(graph, lid),A);
+      poly.add_product(contracted,C);
     } else {
-      poly = flow<G,P>(graph, lid) + flow<G,P>(g2, rid);
-    }    
+      edge_t edge = select_edge(graph);
+
+      // now, delete/contract on the line's endpoints
+      graph.remove_edge(edge);
+      g2.contract_edge(edge);
+      // recursively compute the polynomial, starting with contract
+      P contracted = flow<G,P>(g2, rid);
+      poly = flow<G,P>(graph, lid);
+      if(edge.third > 1) { 
+	poly.add_shifted(contracted,Y(0,edge.third-1));
+      } else {
+	poly += contracted;
+      }    
+    }
   }
 
   // Finally, save computed polynomial
@@ -753,8 +922,10 @@ P flow(G &graph, unsigned int mid) {
     cache.store(key,poly,mid);
     delete [] key;  // free space used by key
   }    
+  delete [] tkey;
 
-  return poly * RF;
+  poly *= RF;
+  return poly;
 }
 
 /* This is the core algorithm for the flow polynomial computation it
@@ -772,7 +943,8 @@ void flowSearch(G &graph, vector<G> &graphs) {
 
   // === 1. APPLY SIMPLIFICATIONS ===
 
-  P RF = Y(reduce_loops(graph));
+  // the loops only matter to the polynomial, which isn't computed here
+  reduce_loops(graph);
 
   // === 2. CHECK IN CACHE ===
 
@@ -882,6 +1054,7 @@ P chromatic(G &graph, unsigned int mid) {
   // === 1. CHECK IN CACHE ===
 
   unsigned char *key = NULL;
+  unsigned char *tkey = NULL; // key for the table only (see lookup_table)
   if(graph.num_vertices() >= small_graph_threshold) {      
     key = graph_key(graph); 
     unsigned int match_id;
@@ -925,6 +1098,8 @@ P chromatic(G &graph, unsigned int mid) {
       poly *= tmp;
     }
     num_completed++;
+  } else if(lookup_table(graph,key,tkey,poly)) {
+    if(write_tree) { write_tree_leaf(mid,graph,cout); }
   } else {
 
     // TREE OUTPUT STUFF
@@ -946,18 +1121,44 @@ P chromatic(G &graph, unsigned int mid) {
       graph.add_edge(edge.first,edge.second);
       g2.simple_contract_edge(edge);  
       
-      // recursively compute the polynomial   
-      poly = chromatic<G,P>(graph, lid) - chromatic<G,P>(g2, rid);
+      // recursively compute the polynomial, starting with contract
+      P contracted = chromatic<G,P>(g2, rid);
+      poly = chromatic<G,P>(graph, lid);
+      poly -= contracted;
     } else {
       // === 4. PERFORM DELETE / CONTRACT ===
-      edge_t edge = select_edge(graph);
+      line_t line;
+      if(reduce_lines) { line = select_line(graph); }
+      // if the ends of the line are adjacent, contracting it leaves a
+      // loop (which simple_contract_line drops); so, stick to edges
+      if(line.size() > 1 && graph.num_edges(line[0].first,line[line.size()-1].second) > 0) {
+	line.clear();
+      }
+
+      if(line.size() > 1) {
+	// as for tutte, where the graph is simple and so every edge
+	// of the line has a contract weight of one
+	num_lines++;
+	P A, C;
+	reduce_line<P>(X(1),line,A,C);
+	graph.remove_line(line);
+	g2.simple_contract_line(line);
+	// recursively compute the polynomial, starting with contract
+	P contracted = chromatic<G,P>(g2, rid);
+	poly.add_product(chromatic<G,P>(graph, lid),A);
+	poly.add_product(contracted,C);
+      } else {
+	edge_t edge = select_edge(graph);
       
-      // now, delete/contract on the line's endpoints
-      graph.remove_edge(edge);
-      g2.simple_contract_edge(edge);  
+	// now, delete/contract on the line's endpoints
+	graph.remove_edge(edge);
+	g2.simple_contract_edge(edge);  
       
-      // recursively compute the polynomial   
-      poly = chromatic<G,P>(graph, lid) + chromatic<G,P>(g2, rid);
+	// recursively compute the polynomial, starting with contract
+	P contracted = chromatic<G,P>(g2, rid);
+	poly = chromatic<G,P>(graph, lid);
+	poly += contracted;
+      }
     } 
   }
 
@@ -969,6 +1170,7 @@ P chromatic(G &graph, unsigned int mid) {
     cache.store(key,poly,mid);
     delete [] key;  // free space used by key
   }
+  delete [] tkey;
 
   return poly;
 }
@@ -1053,42 +1255,37 @@ P tuttex(G &rootgraph) {
 // ---------------------------------------------------------------
 
 string read_line(istream &in) {
-  char c;
   string str;
-
-  in.get(c); 
-  while(!in.eof() && c != '\n') {
-    if(c != '\r') {
-      str = str + c;
-    }
-    in.get(c);  
-  }
-
+  getline(in,str);
+  str.erase(std::remove(str.begin(),str.end(),'\r'),str.end());
   return str;
 }
 
 int parse_number(unsigned int &pos, string const &str) {
-  int s = pos;
+  int r = 0;
   while(pos < str.length() && isdigit(str[pos])) {
+    r = (r * 10) + (str[pos] - '0');
     pos = pos + 1;
   }
-  stringstream ss(str.substr(s,pos));
-  int r;
-  ss >> r;
   return r;
 }
 
+/* Parse a decimal number of any length.  The digits are read nine at
+ * a time into a single word, so that each chunk costs only one
+ * multiply and one add on the biguint, rather than one per digit.
+ */
 biguint parse_bignumber(unsigned int &pos, string const &str) {
-  int s = pos;
+  biguint r(UINT32_C(0));
   while(pos < str.length() && isdigit(str[pos])) {
-    pos = pos + 1;
-  }
-  biguint r;
-  biguint ten = biguint((uint32_t)10);
-  for(unsigned int i=0;i!=(pos-s);++i) {
-    char c=str[pos-(i+1)];
-    uint32_t d = c - '0';
-    r += pow(ten,i) * biguint(d);
+    uint32_t chunk = 0;
+    uint32_t scale = 1;
+    for(unsigned int i=0;i!=9 && pos < str.length() && isdigit(str[pos]);++i) {
+      chunk = (chunk * 10) + (str[pos] - '0');
+      scale = scale * 10;
+      pos = pos + 1;
+    }
+    r *= scale;
+    r += chunk;
   }
   return r;
 }
@@ -1109,7 +1306,7 @@ void skip(unsigned int &pos, string const &in) {
 }
 
 template<class G>
-G read_graph(string in) {
+G read_graph(string const &in) {
   vector<pair<unsigned int, unsigned int> > edgelist;
   unsigned int V = 0, pos = 0;
     
@@ -1139,7 +1336,7 @@ G read_graph(string in) {
 }
 
 template<class G>
-G read_init_graph(string in) {
+G read_init_graph(string const &in) {
   unsigned int pos = 0;
   match('G',pos,in);
   match('[',pos,in);
@@ -1183,8 +1380,13 @@ G read_init_graph(string in) {
   return r; 
 }
 
+/* Parse a polynomial written in the output format.  The flags
+ * xterms and yterms allow terms involving x or y (respectively) to be
+ * discarded, which is needed when loading Tutte polynomials for use
+ * in flow and chromatic computations.
+ */
 template<class P>
-P read_polynomial(string in) {
+P read_polynomial(string const &in, bool xterms = true, bool yterms = true) {
   unsigned int pos = 0;
   P poly;
 
@@ -1225,9 +1427,11 @@ P read_polynomial(string in) {
       }
     }    
 
-    P term(xy_term(xpow,ypow));
-    term *= coeff;
-    poly += term;
+    if((xterms || xpow == 0) && (yterms || ypow == 0)) {
+      P term(xy_term(xpow,ypow));
+      term *= coeff;
+      poly += term;
+    }
     while(pos < in.length() && (in[pos] == ' ' || in[pos] == '+')) {
       pos++;
     }
@@ -1416,6 +1620,32 @@ uint64_t parse_amount(char *str) {
   return r;
 }
 
+/* Load the small graph table from a file in the output format.  That
+ * is, each graph line "G[i] := {...}" is followed by the line
+ * "TP[i] := ..." giving its Tutte polynomial; any other lines are
+ * ignored.  For the flow (resp. chromatic) polynomial, only the terms
+ * of T(0,y) (resp. T(x,0)) are kept, since this is what the
+ * corresponding computation produces.
+ */
+template<class G, class P>
+void load_table(istream &input) {
+  while(!input.eof()) {
+    string line = read_line(input);
+    if(line == "" || line[0] != 'G') { continue; }
+    G graph = compact_graph<G>(read_init_graph<G>(line));
+    P poly = read_polynomial<P>(read_line(input), mode != MODE_FLOW, mode != MODE_CHROMATIC);
+    P p2;
+    unsigned char *key = graph_key(graph); 
+    unsigned int id = 0;
+    if(!table.lookup(key,p2,id)) {
+      table.store(key,poly,id);
+    }
+    delete [] key;  // free space used by key
+    table_threshold = max(table_threshold,graph.num_vertices());
+  }
+  table.reset_stats();
+}
+
 // ---------------------------------------------------------------
 // Statistics Printing Methods
 // ---------------------------------------------------------------
@@ -1557,6 +1787,143 @@ string search_replace(string from, string to, string text) {
   return text;
 }
 
+// ---------------------------------------------------------------
+// Coefficient Representation
+// ---------------------------------------------------------------
+
+/* Where a bound on the coefficients (see coefficient_bits) shows they
+ * fit in 64 or 128 bits, the polynomial is computed with fixed width
+ * coefficients (see fixed_uint.hpp), which never allocate.  In
+ * modular mode, coefficients are instead held as residues modulo
+ * enough word-sized primes (see modvec.hpp).  In either case, the
+ * exact polynomial is reconstructed once the computation is complete,
+ * and biguint is used only when the bound is too large.  Since the
+ * cache and small graph table hold polynomials of one representation
+ * only, they are cleared and reloaded whenever it changes.
+ */
+
+/* Determine how many bits are needed to hold any coefficient of the
+ * graph's polynomial.  The coefficients are nonnegative and sum to
+ * T(1,1), so none exceeds T(1,1) <= T(2,2) = 2^E.  Furthermore,
+ * T(1,1) counts the maximal spanning forests; rooting each tree at
+ * its largest degree vertex, every other vertex picks the edge to its
+ * parent, giving T(1,1) <= the product of the remaining degrees.  This
+ * is usually much tighter.
+ */
+template<class G>
+unsigned int coefficient_bits(G const &graph) {
+  double bits = 0;
+  unsigned int maxdeg = 1;
+  for(typename G::vertex_iterator i(graph.begin_verts());i!=graph.end_verts();++i) {
+    unsigned int d = graph.num_edges(*i);
+    if(d > 0) { bits += log((double) d) / log(2.0); }
+    maxdeg = max(maxdeg,d);
+  }
+  bits -= log((double) maxdeg) / log(2.0);
+  // add a bit to cover any rounding error
+  return min(graph.num_edges(),(unsigned int) bits + 2);
+}
+
+template<class G, class P>
+void store_init_graph(string const &gline, string const &pline) {
+  G init_graph = compact_graph<G>(read_init_graph<G>(gline));
+  P poly = read_polynomial<P>(pline);
+  P p2;
+  unsigned char *key = graph_key(init_graph); 
+  unsigned int id = 0;
+  if(!cache.lookup(key,p2,id)) {
+    cache.store(key,poly,id);
+  }
+  delete [] key;  // free space used by key
+}
+
+template<class G, class P>
+void use_representation(unsigned int rep) {
+  if(rep == cache_rep) { return; }
+  cache_rep = rep;
+  // reloading should not show up in the statistics
+  unsigned long o_nauty_calls = nauty_calls;
+  unsigned long o_key_memo_hits = key_memo_hits;
+  unsigned long o_fpoly_allocations = fpoly_allocations();
+  cache.clear();
+  table.clear();
+  table_threshold = (table_out != NULL) ? table_write_threshold : 0;
+  for(vector<pair<string,string> >::iterator i(init_graphs.begin());i!=init_graphs.end();++i) {
+    store_init_graph<G,P>(i->first,i->second);
+  }
+  if(table_text != "") {
+    istringstream table_in(table_text);
+    load_table<G,P>(table_in);
+  }
+  cache.reset_stats();
+  nauty_calls = o_nauty_calls;
+  key_memo_hits = o_key_memo_hits;
+  fpoly_allocations() = o_fpoly_allocations;
+}
+
+template<class G, class P>
+P compute(G &graph) {
+  if(mode == MODE_CHROMATIC) {      
+    return chromatic<G,P>(graph,1);        
+  } else if(mode == MODE_FLOW) {
+    return flow<G,P>(graph,1);        
+  } else if(mode == MODE_TUTTEX) {
+    return tuttex<G,P>(graph);        
+  } else {
+    return tutte<G,P>(graph,1);        
+  }
+}
+
+// compute using coefficients of type T, then convert back
+template<class G, class P, class T>
+P compute_with(G &graph, unsigned int rep) {
+  typedef typename P::template rebind<T>::other Q;
+  use_representation<G,Q>(rep);
+  return P(compute<G,Q>(graph));
+}
+
+template<class G, class P>
+void solve(G &graph, P &r) {
+  use_representation<G,P>(REP_OTHER);
+  r = compute<G,P>(graph);
+}
+
+// P has biguint coefficients, but the computation is done with the
+// cheapest coefficients able to hold them.
+template<class G, class P>
+void solve_exact(G &graph, P &r) {
+  unsigned int bits = coefficient_bits(graph);
+  unsigned int nprimes = (bits / MODVEC_PRIME_BITS) + 1;
+  if(modular_mode && nprimes <= 1) {
+    r = compute_with<G,P,modvec<1> >(graph,REP_MODVEC+1);
+  } else if(modular_mode && nprimes <= 2) {
+    r = compute_with<G,P,modvec<2> >(graph,REP_MODVEC+2);
+  } else if(modular_mode && nprimes <= 4) {
+    r = compute_with<G,P,modvec<4> >(graph,REP_MODVEC+4);
+  } else if(modular_mode && nprimes <= MODVEC_MAX_PRIMES) {
+    r = compute_with<G,P,modvec<MODVEC_MAX_PRIMES> >(graph,REP_MODVEC+MODVEC_MAX_PRIMES);
+  } else if(fixed_mode && !modular_mode && bits < 64) {
+    r = compute_with<G,P,fixed_uint<uint64_t> >(graph,REP_UINT64);
+#ifdef __SIZEOF_INT128__
+  } else if(fixed_mode && !modular_mode && bits < 128) {
+    r = compute_with<G,P,fixed_uint<unsigned __int128> >(graph,REP_UINT128);
+#endif
+  } else {
+    use_representation<G,P>(REP_BIGUINT);
+    r = compute<G,P>(graph);
+  }
+}
+
+template<class G>
+void solve(G &graph, factor_poly<biguint> &r) {
+  solve_exact<G>(graph,r);
+}
+
+template<class G, unsigned int V>
+void solve(G &graph, univariate_poly<biguint,V> &r) {
+  solve_exact<G>(graph,r);
+}
+
 template<class G, class P>
 void run(istream &input, unsigned int graphs_beg, unsigned int graphs_end, vorder_t vertex_ordering, boolean info_mode, boolean reset_mode) {
   // if auto heuristic is enabled, then we calculate graph density and
@@ -1565,6 +1932,7 @@ void run(istream &input, unsigned int graphs_beg, unsigned int graphs_end, vorde
   unsigned int lineno = 0;
   ngraphs_completed = 0;
   bool auto_heuristic = edge_selection_heuristic == AUTO;
+  nauty_profile = info_mode && verbose;
 
   while(!input.eof() && index < graphs_end) {
     string line = read_line(input);
@@ -1576,15 +1944,9 @@ void run(istream &input, unsigned int graphs_beg, unsigned int graphs_end, vorde
 
     if(line[0] =='G') {
       // this is an initialisation graph
-      G init_graph = compact_graph<G>(read_init_graph<G>(line));
-      P poly = read_polynomial<P>(read_line(input));
-      P p2;
-      unsigned char *key = graph_key(init_graph); 
-      unsigned int id = 0;
-      if(!cache.lookup(key,p2,id)) {
-	cache.store(key,poly,id);
-      }
-      delete [] key;  // free space used by key
+      // this is stored when the cache is next (re)loaded
+      init_graphs.push_back(make_pair(line,read_line(input)));
+      cache_rep = REP_NONE;
       continue;
     } 
 
@@ -1612,6 +1974,7 @@ void run(istream &input, unsigned int graphs_beg, unsigned int graphs_end, vorde
     // now reset all stats information
     if(reset_mode) { cache.clear(); }
     cache.reset_stats();
+    table.reset_stats();
     cache_hit_sizes.clear();
     num_steps = 0;
     old_num_steps = 0;
@@ -1619,6 +1982,12 @@ void run(istream &input, unsigned int graphs_beg, unsigned int graphs_end, vorde
     num_disbicomps = 0;
     num_trees = 0;
     num_cycles = 0;
+    num_lines = 0;
+    num_2sums = 0;
+    nauty_calls = 0;
+    nauty_time = 0;
+    key_memo_hits = 0;
+    fpoly_allocations() = 0;
     unsigned int V(start_graph.num_vertices());
     unsigned int E(start_graph.num_edges());
     unsigned int EP(start_graph.num_underlying_edges());
@@ -1642,16 +2011,11 @@ void run(istream &input, unsigned int graphs_beg, unsigned int graphs_end, vorde
 
     P tuttePoly;
 
-    if(mode == MODE_CHROMATIC) {      
-      tuttePoly = chromatic<G,P>(perm_graph,1);        
-    } else if(mode == MODE_FLOW) {
-      tuttePoly = flow<G,P>(perm_graph,1);        
-    } else if(mode == MODE_TUTTE) {
-      tuttePoly = tutte<G,P>(perm_graph,1);        
-    } else if(mode == MODE_TUTTEX) {
-      tuttePoly = tuttex<G,P>(perm_graph);        
+    if(mode != MODE_TUTTE_SPLIT && mode != MODE_FLOW_SPLIT) {      
+      solve<G>(perm_graph,tuttePoly);
     } else if(mode == MODE_TUTTE_SPLIT) { 
       vector<G> graphs;
+      use_representation<G,P>(REP_OTHER); // loads the initialisation graphs
       tutteSearch<G,P>(perm_graph,graphs);        
       for(typename vector<G>::const_iterator i(graphs.begin());i!=graphs.end();++i) {      	
 	cout << input_graph_str(*i) << endl;
@@ -1659,6 +2023,7 @@ void run(istream &input, unsigned int graphs_beg, unsigned int graphs_end, vorde
       continue;
     } else { // MODE_FLOW_SPLIT
       vector<G> graphs;
+      use_representation<G,P>(REP_OTHER); // loads the initialisation graphs
       flowSearch<G,P>(perm_graph,graphs);        
       for(typename vector<G>::const_iterator i(graphs.begin());i!=graphs.end();++i) {      	
 	cout << input_graph_str(*i) << endl;
@@ -1668,17 +2033,29 @@ void run(istream &input, unsigned int graphs_beg, unsigned int graphs_end, vorde
 
     if(write_tree) { write_tree_end(ngraphs_completed); }
 
+    // evaluate at all the points needed in one batch; in tutte mode,
+    // the info output also checks T(1,1), T(2,2) and T(-1,-1).
+    bool check_values = info_mode && mode == MODE_TUTTE && !eval_only;
+    vector<pair<int,int> > points(evalpoints);
+    if(check_values) {
+      points.push_back(make_pair(1,1));
+      points.push_back(make_pair(2,2));
+      points.push_back(make_pair(-1,-1));
+    }
+    vector<bigint> values = tuttePoly.substitute(points);
+    unsigned int first_check = evalpoints.size();
+
     if(!verbose) {
-      for(vector<pair<int,int> >::iterator i(evalpoints.begin());i!=evalpoints.end();++i) {
-	cout << tuttePoly.substitute(i->first,i->second) << "\t";
+      for(unsigned int i=0;i!=evalpoints.size();++i) {
+	cout << values[i] << "\t";
       }
       cout << endl;
 	
       if(info_mode) {
 	cout << V << "\t" << E << "\t" << EP;    
 	cout << "\t" << setprecision(3) << global_timer.elapsed() << "\t" << num_steps << "\t" << num_bicomps << "\t" << num_disbicomps << "\t" << num_cycles << "\t" << num_trees;
-	if(mode == MODE_TUTTE) {
-	  cout << "\t" << tuttePoly.substitute(1,1) << "\t" << tuttePoly.substitute(2,2);
+	if(check_values) {
+	  cout << "\t" << values[first_check] << "\t" << values[first_check+1];
 	}
       } 
     } else {
@@ -1686,6 +2063,10 @@ void run(istream &input, unsigned int graphs_beg, unsigned int graphs_end, vorde
       if(global_timer.elapsed() >= timeout) {
 	// catch timeout case to avoid confusion.
 	cerr << "Timeout!!" << endl;
+      } else if(eval_only) {
+	// no polynomial to print, just the values below
+	cout << "G[" << (ngraphs_completed+1) << "] := {" << input_graph_str(start_graph) << "}" << endl;
+	TP = (mode == MODE_FLOW) ? "FP" : (mode == MODE_CHROMATIC) ? "CP" : "TP";
       } else if(mode == MODE_TUTTE) {	
 	cout << "G[" << (ngraphs_completed+1) << "] := {" << input_graph_str(start_graph) << "}" << endl;
 	cout << "TP[" << (ngraphs_completed+1) << "] := " << tuttePoly.str() << " :" << endl;
@@ -1701,8 +2082,8 @@ void run(istream &input, unsigned int graphs_beg, unsigned int graphs_end, vorde
 	TP = "CP";
       }
 
-      for(vector<pair<int,int> >::iterator i(evalpoints.begin());i!=evalpoints.end();++i) {
-	cout << TP << "[" << (ngraphs_completed+1) << "](" << i->first << "," << i->second << ") = " << tuttePoly.substitute(i->first,i->second) << endl;
+      for(unsigned int i=0;i!=evalpoints.size();++i) {
+	cout << TP << "[" << (ngraphs_completed+1) << "](" << evalpoints[i].first << "," << evalpoints[i].second << ") = " << values[i] << endl;
       }
 
       if(info_mode) {
@@ -1712,17 +2093,25 @@ void run(istream &input, unsigned int graphs_beg, unsigned int graphs_end, vorde
 	cout << "Number of Biconnected Components Extracted: " << num_bicomps << "." << endl;	
 	cout << "Number of Biconnected Components Separated: " << num_disbicomps << "." << endl;	
 	cout << "Number of Cycles Terminated: " << num_cycles << "." << endl;	
+	if(reduce_lines) { cout << "Number of Lines Reduced: " << num_lines << "." << endl; }
+	if(reduce_2cuts) { cout << "Number of 2-Sums Split: " << num_2sums << "." << endl; }
 	cout << "Number of Trees Terminated: " << num_trees << "." << endl;	
 	cout << "Number of Completed Graphs Terminated: " << num_completed << "." << endl;	
+	cout << "Number of Nauty Calls: " << nauty_calls << "." << endl;	
+	cout << "Number of Key Memo Hits: " << key_memo_hits << "." << endl;	
+	cout << "Number of Poly Allocations: " << fpoly_allocations() << " (" << setprecision(3) << ((double) fpoly_allocations() / num_steps) << "/step)." << endl;
+	cout << "Number of Table Hits: " << table.num_hits() << "." << endl;	
 	cout << "Time : " << setprecision(3) << global_timer.elapsed() << "s" << endl;
+	cout << "Time in Nauty (wall clock) : " << setprecision(3) << nauty_time << "s (" << ((nauty_time * 1000000) / num_steps) << "us/step)" << endl;
+	cout << "Peak Memory Usage: " << peak_memory() << "KB." << endl;
 
-	if(mode == MODE_TUTTE) {
+	if(check_values) {
 	  // only print these evaluation points when in tutte mode
-	  cout << "T(1,1) = " << tuttePoly.substitute(1,1) << endl;
-	  cout << "T(2,2) = " << tuttePoly.substitute(2,2) << " (should be " << pow(biguint(UINT32_C(2)),E) << ")" << endl;	
+	  cout << "T(1,1) = " << values[first_check] << endl;
+	  cout << "T(2,2) = " << values[first_check+1] << " (should be " << pow(biguint(UINT32_C(2)),E) << ")" << endl;	
 	  // The tutte at T(-1,-1) should always give a (positive or
 	  // negative) power of 2. 
-	  bigint Tm1m1 = tuttePoly.substitute(-1,-1);
+	  bigint Tm1m1 = values[first_check+2];
 	  bigint Tm1m1pow = INT32_C(0);
 
 	  while((Tm1m1 % INT32_C(2)) == INT32_C(0)) {
@@ -1761,6 +2150,15 @@ int main(int argc, char *argv[]) {
   #define OPT_SMALLGRAPHS 5
   #define OPT_NGRAPHS 6
   #define OPT_STDIN 24
+  #define OPT_TABLE 25
+  #define OPT_WRITETABLE 26
+  #define OPT_TABLESIZE 27
+  #define OPT_DUMPKEYS 28
+  #define OPT_NOKEYMEMO 29
+  #define OPT_LABELLER 35
+  #define OPT_EVALONLY 36
+  #define OPT_MODULAR 37
+  #define OPT_BIGUINT 38
   #define OPT_GRAPHS 19
   #define OPT_TIMEOUT 7
   #define OPT_EVALPOINT 8
@@ -1780,10 +2178,12 @@ int main(int argc, char *argv[]) {
   #define OPT_TUTTEX 23
   #define OPT_SIMPLE_POLY 30
   #define OPT_FACTOR_POLY 31
+  #define OPT_UNIVARIATE_POLY 39 // the default (factor_poly, unless univariate suffices)
   #define OPT_XML_OUT 32
   #define OPT_TREE_OUT 33
   #define OPT_FULLTREE_OUT 34
   #define OPT_WITHLINES 43
+  #define OPT_WITH2CUTS 46
   #define OPT_NOMULTICYCLES 44
   #define OPT_NOMULTIEDGES 45
   #define OPT_MAXSDEGREE 49
@@ -1846,6 +2246,10 @@ int main(int argc, char *argv[]) {
     {"cut", no_argument,NULL,OPT_CUT},
     {"small-graphs",required_argument,NULL,OPT_SMALLGRAPHS},
     {"simple-poly",no_argument,NULL,OPT_SIMPLE_POLY},
+    {"factor-poly",no_argument,NULL,OPT_FACTOR_POLY},
+    {"eval-only",no_argument,NULL,OPT_EVALONLY},
+    {"modular",no_argument,NULL,OPT_MODULAR},
+    {"biguint",no_argument,NULL,OPT_BIGUINT},
     {"tree",no_argument,NULL,OPT_TREE_OUT},
     {"full-tree",no_argument,NULL,OPT_FULLTREE_OUT},
     {"xml-tree",no_argument,NULL,OPT_XML_OUT},
@@ -1853,7 +2257,15 @@ int main(int argc, char *argv[]) {
     {"graphs",required_argument,NULL,OPT_GRAPHS},
     {"no-multicycles",no_argument,NULL,OPT_NOMULTICYCLES},
     {"no-multiedges",no_argument,NULL,OPT_NOMULTIEDGES},
+    {"with-lines",no_argument,NULL,OPT_WITHLINES},
+    {"with-2cuts",no_argument,NULL,OPT_WITH2CUTS},
     {"add-contract",no_argument,NULL,OPT_USEADDCONTRACT},
+    {"table",required_argument,NULL,OPT_TABLE},
+    {"write-table",required_argument,NULL,OPT_WRITETABLE},
+    {"table-size",required_argument,NULL,OPT_TABLESIZE},
+    {"dump-keys",required_argument,NULL,OPT_DUMPKEYS},
+    {"no-key-memo",no_argument,NULL,OPT_NOKEYMEMO},
+    {"labeller",required_argument,NULL,OPT_LABELLER},
     NULL
   };
   
@@ -1866,6 +2278,11 @@ int main(int argc, char *argv[]) {
     " -t     --timeout=<x>             timeout after x seconds",
     " -s<x>  --split=<x>               split the input graph(s) into a number of smaller graphs with no more than x vertices",
     " -Tx,y  --eval=x,y                evaluate the computed polynomial at x,y",
+    "        --eval-only               compute only the values at the --eval points, not the polynomial",
+    "        --modular                 compute coefficients modulo several primes, reconstructing them at the end",
+    "        --biguint                 always use arbitrary precision coefficients, even when 64 or 128 bits suffice",
+    "        --simple-poly             store polynomials as a map of terms (slow, but useful for comparison)",
+    "        --factor-poly             store flow and chromatic polynomials in x and y, rather than just the one variable",
     "        --small-graphs=size       set threshold for small graphs.  Default is 5.",
     " -n<x>  --ngraphs=<number>        number of graphs to process from input file",
     " -g<x:y>  --graphs=<start:end>    which graphs to process from input file, e.g. 2:10 processes the 2nd to tenth inclusive",
@@ -1885,6 +2302,10 @@ int main(int argc, char *argv[]) {
     "        --cache-stats[=<file>]    print detailed cache statistics, or write them to a file.",
     "        --cache-reset             reset the cache between graphs in a batch",
     "        --no-caching              disable caching",
+    " \nsmall graph table options:",
+    "        --table=<file>            load table of Tutte polynomials for small graphs (in output format)",
+    "        --write-table=<file>      write Tutte polynomials of small biconnected graphs computed to file",
+    "        --table-size=<number>     largest graph (in vertices) written by --write-table.  Default is 7.",
     " \nedge selection heuristics:",
     "        --sparse                  use best heuristic for \"sparse\" graphs.",
     "        --dense                   use best heuristic for \"dense\" graphs.",
@@ -1904,14 +2325,19 @@ int main(int argc, char *argv[]) {
     " \nother options:",
     "        --no-multiedges           do not reduce multiedges in one go",
     "        --no-multicycles          do not reduce multicycles in one go",
+    "        --with-lines              delete/contract lines of degree 2 vertices in one go (tutte, flow and chromatic only)",
+    "        --with-2cuts              split biconnected graphs on 2-vertex cuts (tutte only)",
     "        --add-contract            perform add/contract (currently only for chromatic)",    
+    "        --dump-keys=<file>        write every graph key generated to file (for benchmarking)",
+    "        --no-key-memo             always call nauty, even for recently seen labelled graphs",
+    "        --labeller=<name>         canonical labelling engine: nauty (default) or tiny",
     NULL
   };
 
   unsigned int v;
   uint64_t cache_size(256 * 1024 * 1024); 
   unsigned int cache_buckets(1000000);     // default 1M buckets
-  unsigned int poly_rep(OPT_FACTOR_POLY);
+  unsigned int poly_rep(OPT_UNIVARIATE_POLY);
   unsigned int graphs_beg(0); 
   unsigned int graphs_end(UINT_MAX); // default is to do every graph in input file
   bool info_mode=false;
@@ -1919,6 +2345,9 @@ int main(int argc, char *argv[]) {
   bool cache_stats=false;
   bool stdin=false;
   string cache_stats_file = "";
+  string table_file = "";
+  string write_table_file = "";
+  string dump_keys_file = "";
   vorder_t vertex_ordering(V_DFS);
 
   while((v=getopt_long(argc,argv,"qi::c:n:s:t:T:",long_options,NULL)) != -1) {
@@ -2036,10 +2465,47 @@ int main(int argc, char *argv[]) {
     case OPT_CACHERESET:
       reset_mode = true;
       break;
+    // --- TABLE OPTIONS ---
+    case OPT_TABLE:
+      table_file = string(optarg);
+      break;
+    case OPT_WRITETABLE:
+      write_table_file = string(optarg);
+      break;
+    case OPT_TABLESIZE:
+      table_write_threshold = atoi(optarg);
+      break;
+    case OPT_DUMPKEYS:
+      dump_keys_file = string(optarg);
+      break;
+    case OPT_NOKEYMEMO:
+      use_key_memo = false;
+      break;
+    case OPT_LABELLER:
+      try {
+	graph_labeller = create_labeller(optarg);
+      } catch(std::runtime_error &e) {
+	cout << e.what() << endl;
+	exit(1);
+      }
+      break;
     // --- POLY OPTIONS ---
     case OPT_SIMPLE_POLY:
       poly_rep = OPT_SIMPLE_POLY;
       break;
+    case OPT_FACTOR_POLY:
+      poly_rep = OPT_FACTOR_POLY;
+      break;
+    case OPT_EVALONLY:
+      poly_rep = OPT_EVALONLY;
+      eval_only = true;
+      break;
+    case OPT_MODULAR:
+      modular_mode = true;
+      break;
+    case OPT_BIGUINT:
+      fixed_mode = false;
+      break;
     // --- HEURISTICS ---
     case OPT_MINDEGREE:
       edge_selection_heuristic = MINIMISE_DEGREE;
@@ -2112,6 +2578,12 @@ int main(int argc, char *argv[]) {
     case OPT_NOMULTIEDGES:
       reduce_multiedges=false;
       break;
+    case OPT_WITHLINES:
+      reduce_lines=true;
+      break;
+    case OPT_WITH2CUTS:
+      reduce_2cuts=true;
+      break;
     case OPT_USEADDCONTRACT:
       use_add_contract=true;
       break;
@@ -2132,6 +2604,35 @@ int main(int argc, char *argv[]) {
     exit(1);
   }
 
+  if(reduce_lines && mode != MODE_TUTTE && mode != MODE_FLOW && mode != MODE_CHROMATIC) {
+    cout << "Can only use --with-lines for tutte, flow and chromatic polynomials" << endl;
+    exit(1);
+  } else if(reduce_2cuts && mode != MODE_TUTTE) {
+    cout << "Can only use --with-2cuts for tutte polynomials" << endl;
+    exit(1);
+  }
+
+  if(eval_only) {
+    if(evalpoints.empty()) {
+      cout << "Must specify at least one point (using --eval) with --eval-only" << endl;
+      exit(1);
+    } else if(write_table_file != "") {
+      cout << "Cannot write small graph table with --eval-only" << endl;
+      exit(1);
+    } else if(mode == MODE_TUTTE_SPLIT || mode == MODE_FLOW_SPLIT) {
+      cout << "Cannot split graphs with --eval-only" << endl;
+      exit(1);
+    }
+    for(unsigned int i=0;i!=evalpoints.size();++i) {
+      // 2-sums divide by xy - x - y, which is zero at (0,0) and (2,2)
+      int x = evalpoints[i].first, y = evalpoints[i].second;
+      if(reduce_2cuts && (x-1)*(y-1) == 1) {
+	cout << "Cannot use --with-2cuts with --eval-only at (" << x << "," << y << ")" << endl;
+	exit(1);
+      }
+    }
+  }
+
   // setupt stats output
   fstream fstats_out;
   if(cache_stats_file != "") {
@@ -2139,12 +2640,32 @@ int main(int argc, char *argv[]) {
     stats_out = &fstats_out;
   }
 
+  // setup graph key dump
+  fstream fkeys_out;
+  if(dump_keys_file != "") {
+    fkeys_out.open(dump_keys_file.c_str(),fstream::out | fstream::binary);
+    graph_key_dump = &fkeys_out;
+  }
+
+  // setup small graph table output
+  fstream ftable_out;
+  if(write_table_file != "") {
+    if(mode != MODE_TUTTE) {
+      cout << "Can only write small graph table when computing Tutte polynomials" << endl;
+      exit(1);
+    }
+    ftable_out.open(write_table_file.c_str(),fstream::out);
+    table_out = &ftable_out;
+    table_threshold = table_write_threshold;
+  }
+
   // -------------------------------------------------
   // Initialise Cache 
   // -------------------------------------------------
   try {
     cache.resize(cache_size);
     cache.rebucket(cache_buckets);
+    table.set_no_replacement();
     
   // -------------------------------------------------
   // Register alarm signal for printing status updates
@@ -2173,10 +2694,26 @@ int main(int argc, char *argv[]) {
       input = new ifstream(argv[optind]);    
     }
 
-    if(poly_rep == OPT_FACTOR_POLY) {
+    if(table_file != "") {
+      // this is loaded once the representation is known
+      ifstream table_in(table_file.c_str());
+      if(!table_in) { throw runtime_error("unable to open table file \"" + table_file + "\""); }
+      stringstream ss;
+      ss << table_in.rdbuf();
+      table_text = ss.str();
+    }
+
+    if(poly_rep == OPT_UNIVARIATE_POLY && mode == MODE_CHROMATIC) {
+      run<spanning_graph<adjacency_list<> >,univariate_poly<biguint,UPOLY_X> >(*input,graphs_beg,graphs_end,vertex_ordering,info_mode,reset_mode);
+    } else if(poly_rep == OPT_UNIVARIATE_POLY && (mode == MODE_FLOW || mode == MODE_FLOW_SPLIT)) {
+      run<spanning_graph<adjacency_list<> >,univariate_poly<biguint,UPOLY_Y> >(*input,graphs_beg,graphs_end,vertex_ordering,info_mode,reset_mode);
+    } else if(poly_rep == OPT_FACTOR_POLY || poly_rep == OPT_UNIVARIATE_POLY) {
       run<spanning_graph<adjacency_list<> >,factor_poly<biguint> >(*input,graphs_beg,graphs_end,vertex_ordering,info_mode,reset_mode);
+    } else if(poly_rep == OPT_EVALONLY) {
+      eval_poly<>::set_points(evalpoints);
+      run<spanning_graph<adjacency_list<> >,eval_poly<> >(*input,graphs_beg,graphs_end,vertex_ordering,info_mode,reset_mode);
     } else {
-      //      run<spanning_graph<adjacency_list<> >,simple_poly<> >(input,ngraphs,vertex_ordering);
+      run<spanning_graph<adjacency_list<> >,simple_poly<> >(*input,graphs_beg,graphs_end,vertex_ordering,info_mode,reset_mode);
     }    
 
     if(cache_stats) {
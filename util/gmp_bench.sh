@@ -0,0 +1,40 @@
+#!/bin/sh
+
+# Compare the built-in biguint kernels with the GMP ones, on time and
+# peak memory, for each of the given example graphs.  This needs two
+# builds of tutte, one configured as normal and one configured with
+# --with-gmp, given in the TUTTE and TUTTE_GMP environment variables:
+#
+#   TUTTE_GMP=../gmp-build/tutte/tutte util/gmp_bench.sh examples/k14 examples/edge30
+#
+# Coefficients are always held as biguints (i.e. --biguint), since
+# otherwise small graphs never reach the biguint kernels at all.  Any
+# further options for tutte can be given in the OPTIONS environment
+# variable.
+
+FILES=$@
+
+TUTTE=${TUTTE:-`dirname $0`/../tutte/tutte}
+
+if [ -z "$TUTTE_GMP" ]; then
+ echo "TUTTE_GMP must give a tutte binary configured --with-gmp"
+ exit 1
+fi
+
+printf "%-24s %-10s %10s %12s\n" "GRAPH" "KERNELS" "TIME (s)" "MEMORY (KB)"
+
+for f in $FILES
+do
+ for k in builtin gmp
+ do
+  if [ "$k" = "gmp" ]; then
+   BIN=$TUTTE_GMP
+  else
+   BIN=$TUTTE
+  fi
+  OUT=`$BIN --info=1000 --biguint $OPTIONS $f`
+  TIME=`echo "$OUT" | sed -n 's/^Time : \([0-9.e+-]*\)s.*$/\1/p' | tail -1`
+  MEM=`echo "$OUT" | sed -n 's/^Peak Memory Usage: \([0-9]*\)KB.*$/\1/p' | tail -1`
+  printf "%-24s %-10s %10s %12s\n" `basename $f` $k $TIME $MEM
+ done
+done
@@ -0,0 +1,37 @@
+#!/bin/sh
+
+# Compare the polynomial representations on time and peak memory, for
+# each of the given example graphs.  Any further options for tutte
+# (e.g. --flow or --chromatic) can be given in the OPTIONS environment
+# variable:
+#
+#   OPTIONS=--chromatic util/poly_bench.sh examples/edge20 examples/k12
+#
+# The representations compared are the default (factor_poly, or a
+# univariate_poly for --flow and --chromatic), --factor-poly,
+# --simple-poly, and the default with --biguint or --modular
+# coefficients.
+
+FILES=$@
+
+TUTTE=${TUTTE:-`dirname $0`/../tutte/tutte}
+
+REPS="default --factor-poly --simple-poly --biguint --modular"
+
+printf "%-24s %-16s %10s %12s\n" "GRAPH" "REPRESENTATION" "TIME (s)" "MEMORY (KB)"
+
+for f in $FILES
+do
+ for r in $REPS
+ do
+  if [ "$r" = "default" ]; then
+   OPT=""
+  else
+   OPT=$r
+  fi
+  OUT=`$TUTTE --info=1000 $OPTIONS $OPT $f`
+  TIME=`echo "$OUT" | sed -n 's/^Time : \([0-9.e+-]*\)s.*$/\1/p' | tail -1`
+  MEM=`echo "$OUT" | sed -n 's/^Peak Memory Usage: \([0-9]*\)KB.*$/\1/p' | tail -1`
+  printf "%-24s %-16s %10s %12s\n" `basename $f` $r $TIME $MEM
+ done
+done